@@ -0,0 +1,39 @@
+#!/bin/sh
+#
+# builds both solvers and benchmarks every engine and
+# the branching heuristics on the grids/ corpus
+#
+# usage: ./bench.sh [runs] [csv]
+#
+# the environment variables CC and CFLAGS are honored
+
+set -e
+
+runs=${1:-10}
+csv=${2:-bench.csv}
+cc=${CC:-cc}
+cflags=${CFLAGS:--O2 -march=native}
+
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+$cc $cflags -pthread -o "$tmp/ssud" src/ssud.c src/sudoku.c
+$cc $cflags -pthread -o "$tmp/swip" src/swip.c src/sudoku.c
+
+: > "$csv"
+for run in "ssud -s" "ssud" "swip -s" "swip" "swip -x" "swip -E bits" \
+  "swip -s -H all"; do
+  set -- $run
+  bin=$1
+  shift
+  "$tmp/$bin" "$@" -B "$runs" -o "$tmp/part.csv" grids/grid*.txt
+  echo
+  if [ -s "$csv" ]; then
+    # header is already there
+    tail -n +2 "$tmp/part.csv" >> "$csv"
+  else
+    cat "$tmp/part.csv" >> "$csv"
+  fi
+done
+
+echo "results written to $csv"
@@ -1,4 +1,3 @@
-
 /** 
  * To the extent possible under law, the author(s) have dedicated 
  * all copyright and related and neighboring rights to this software
@@ -15,14 +14,14 @@
 #include <stdio.h> /* stdin, feof, fgetc */
 #include <stdbool.h> /* bool, true false */
 #include <string.h> /* memcpy */
-#include <pthread.h> /* pthread ... */
 #include <assert.h> /* assert */
-#include <unistd.h> /* usleep */
+#include <time.h> /* clock_gettime */
+
+#include "sudoku.h"
 
-#define NOINDEX (9*9)+1
-#define SRUNNING 1
-#define SFAILURE 2
-#define SSUCCESS 3
+#if SBOX != 3
+  #error "ssud only solves 9*9 grids"
+#endif
 
 /**
  * program options
@@ -30,10 +29,26 @@
 struct sopts {
   /* use threads */
   bool threads;
+  /* number of worker threads, 0 for one per cpu */
+  unsigned jobs;
   /* use fancy output-format */
   bool fancy;
   /* show help */
   bool help;
+  /* batch mode */
+  bool batch;
+  /* print search statistics */
+  bool verbose;
+  /* benchmark mode */
+  bool bench;
+  /* benchmark runs and warmup runs per grid */
+  unsigned reps;
+  unsigned warm;
+  /* benchmark csv output file */
+  const char *csv;
+  /* grid files (benchmark mode) */
+  char **files;
+  unsigned nfiles;
 };
 
 /**
@@ -46,374 +61,24 @@ struct sopts {
 } while (0)
 
 /**
- * checks if the given number can be placed
- * in the given row and column
+ * sudoku solver entrypoint, the solver of the
+ * context is multi-threaded unless -s was given
  *
+ * @param  ctx  the solver
  * @param  grid the sudoku grid
- * @param  num  the number to be placed
- * @param  row  the row index
- * @param  col  the column index
- * @return      true if the number can be placed, false otherwise
+ * @return      SUD_OK or SUD_NOSOL
  */
-static bool check_number (
-  unsigned grid[], 
-  unsigned num, 
-  unsigned row, 
-  unsigned col
+static int solve_puzzle (
+  struct sud_ctx *ctx,
+  sud_cell grid[]
 ) {
+  assert(ctx != 0);
   assert(grid != 0);
-  /* calculate region */
-  const unsigned rx = row / 3 * 3;
-  const unsigned ry = col / 3 * 3;
-  for (unsigned i = 0; i < 9; ++i) {
-    /* check row and column */
-    if (
-      num == grid[(row * 9) + i] ||
-      num == grid[col + (i * 9)]
-    ) {
-      /* number already set in row/column */
-      return false;
-    }
-    /* check region */
-    unsigned reg = 
-      (rx + (i / 3)) * 9 + 
-      (ry + (i % 3));
-    if (num == grid[reg]) {
-      /* number already set in 3*3 region */
-      return false;
-    }
+  const int res = sud_solve(ctx, grid);
+  if (res != SUD_OK && res != SUD_NOSOL) {
+    whops("%s", sud_message(ctx));
   }
-  return true;
-}
-
-/**
- * calculates a score based on seen numbers
- * in the given row and column (and group)
- *
- * @param  grid the sudoku grid
- * @param  row  the row
- * @param  col  column
- * @return      the score
- */
-static signed calc_score (
-  unsigned grid[],
-  unsigned row,
-  unsigned col
-) {
-  assert(grid != 0);
-  unsigned seen[10] = {0};
-  /* calculate region */
-  const unsigned rx = row / 3 * 3;
-  const unsigned ry = col / 3 * 3;
-  for (unsigned i = 0; i < 9; ++i) {
-    unsigned rnm = grid[(row * 9) + i];
-    unsigned cnm = grid[col + (i * 9)];
-    unsigned reg = 
-      (rx + (i / 3)) * 9 +
-      (ry + (i % 3));
-    unsigned gnm = grid[reg];
-    seen[rnm] = 1;
-    seen[cnm] = 1;
-    seen[gnm] = 1;
-  }
-  /* calculate score */
-  signed scr = 0;
-  for (unsigned i = 1; i < 10; ++i) {
-    scr += seen[i];
-  }
-  return scr;
-}
-
-/**
- * returns a index in the grid with the least possibilities
- *
- * @param  grid the sudoku grid
- * @return      the index or 81 if no index was found
- */
-static unsigned find_slot (
-  unsigned grid[]
-) {
-  assert(grid != 0);
-  unsigned idx = NOINDEX;
-  /* score benchmark, the higher the better */
-  signed csc = 0;
-  signed psc = -1;
-  for (unsigned row = 0; row < 9; ++row) {
-    for (unsigned col = 0; col < 9; ++col) {
-      if (grid[row * 9 + col] == 0) {
-        csc = calc_score(grid, row, col);
-        if (csc > 7) {
-          /* best possible result */
-          return row * 9 + col;
-        }
-        if (csc > psc) {
-          psc = csc;
-          idx = row * 9 + col;
-        }
-      }
-    }
-  }
-  return idx;
-}
-
-/**
- * tries to find a solution for the given puzzle.
- * nothing fancy, just a simple/stupid xxx (badword on github!)
- *
- * single threaded
- *
- * @param  grid the sudoku grid
- * @param  idx  the index in the grid to be checked
- * @return      true if a solution was found, false otherwise
- */
-static bool find_solution_st (
-  unsigned grid[]
-) {
-  assert(grid != 0);
-  /* find the first empty slot 
-    with least possibilities */
-  unsigned idx;
-  idx = find_slot(grid);
-
-  if (idx == NOINDEX) {
-    /* no empty slot found */
-    return true;
-  }
-
-  /* slot is empty, start xxx (badword on github) */
-  const unsigned row = idx / 9;
-  const unsigned col = idx % 9;
-  /* this loop is manually unrolled */
-  /* normally this would be a for-loop
-    incrementing num from 1 to 9 */
-  #define UNROLLED_CHECK(num)                \
-    if (check_number(grid, num, row, col)) { \
-      grid[idx] = num;                       \
-      if (find_solution_st(grid)) {          \
-        return true;                         \
-      }                                      \
-      grid[idx] = 0;                         \
-    }
-  UNROLLED_CHECK(1);
-  UNROLLED_CHECK(2);
-  UNROLLED_CHECK(3);
-  UNROLLED_CHECK(4);
-  UNROLLED_CHECK(5);
-  UNROLLED_CHECK(6);
-  UNROLLED_CHECK(7);
-  UNROLLED_CHECK(8);
-  UNROLLED_CHECK(9);
-  #undef UNROLLED_CHECK
-  /* no solution found */
-  return false;
-}
-
-/**
- * callback for pthread
- *
- * @param slot
- */
-static void * find_solution_th (void *pass) 
-{
-  assert(pass != 0);
-  unsigned *smem = pass;
-  unsigned *stat = smem; /* status slot */
-  unsigned *grid = smem + 1;
-  *stat = SRUNNING;
-  /* set cancel state */
-  pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, 0);
-  /* use the single-thread solver */
-  if (find_solution_st(grid)) {
-    /* solution was found */
-    *stat = SSUCCESS;
-  } else {
-    *stat = SFAILURE;
-  }
-  /* get out */
-  return 0;
-}
-
-/**
- * starts the single-threaded solver in a thread
- *
- * @param pt   the thread handle
- * @param grid the grid memory for this thread
- * @param smem the memory slot for this thread
- * @param idx  the index in the grid we're at
- * @param num  the number to be tested
- * @return     the memory slot
- */
-static void solve_fork (
-  pthread_t *const pt,
-  unsigned grid[],
-  unsigned *smem,
-  unsigned idx,
-  unsigned num
-) {
-  assert(grid != 0);
-  assert(smem != 0);
-  /* first slot is for the success/failure status */
-  memcpy(smem + 1, grid, sizeof(unsigned)*9*9);
-  /* fill in the number to test */
-  smem[idx + 1] = num;
-  /* fork off! */
-  pthread_create(pt, 0, find_solution_th, smem);
-}
-
-/**
- * joins the given thread back
- *
- * @param  pt   the pthread handle
- * @param  pi   thread id
- * @param  grid the grid memory
- * @param  copy true if the result should be copied
- * @param  tmem  the thread memory
- * @return      true if a solution was found
- */
-static bool solve_join (
-  pthread_t *const pt,
-  const unsigned pi,
-  unsigned grid[],
-  bool *const sfnd,
-  const unsigned *const tmem
-) {
-  assert(pt != 0);
-  assert(grid != 0);
-  assert(tmem != 0);
-
-  /* unsigned int should be atomic, but just to be safe */
-  static pthread_mutex_t mtx =
-    PTHREAD_MUTEX_INITIALIZER;
-
-  if (*sfnd) {
-    /* thread no longer needed */
-    pthread_cancel(*pt);
-    pthread_join(*pt, 0);
-    return true;
-  }
-
-  /* check thread status */
-  pthread_mutex_lock(&mtx);
-
-  if (*tmem == SRUNNING) {
-    /* thread is still running */
-    pthread_mutex_unlock(&mtx);
-    return false;
-  }
-
-  pthread_join(*pt, 0);
-  
-  if (!*sfnd) {
-    if (*tmem == SSUCCESS) {
-      /* copy solution */
-      memcpy(grid, tmem + 1, sizeof(unsigned)*9*9);
-      *sfnd = true;
-    }
-  }
-
-  pthread_mutex_unlock(&mtx);
-  return true;
-}
-
-/**
- * starts the xxx (bad word on github) in n-threads
- *
- * @see find_solution_st
- *
- * @param  grid the sudoku grid
- * @param  idx  the index in the grid to be checked
- * @return      true if a thread came back with a solution, false otherwise
- */
-static bool find_solution_mt (
-  unsigned grid[]
-) {
-  assert(grid != 0);
-  /* keep things simple, stupid */
-  /* one thread for each possible number */
-  pthread_t pool[9] = {0};
-  unsigned *smem[9] = {0};
-  unsigned pidx = 0;
-
-  /* to keep track of running threads */
-  bool pact[9] = {false};
-  /* status flag */
-  bool sfnd = false;
-
-  /* find the first empty slot 
-    with least possibilities */
-  unsigned idx;
-  idx = find_slot(grid);
-
-  if (idx == NOINDEX) {
-    /* no empty slot found */
-    return true;
-  }
-
-  /* we found a empty slot */
-  const unsigned row = idx / 9;
-  const unsigned col = idx % 9;
-
-  /* start one thread for each possible number */
-  for (unsigned num = 1; num <= 9; ++num) {
-    if (check_number(grid, num, row, col)) {
-      unsigned *tmem = calloc(9*9+1, sizeof(unsigned));
-      pthread_t *thrd = &pool[pidx];
-      solve_fork(thrd, grid, tmem, idx, num);
-      /* next thread */
-      pact[pidx] = true;
-      smem[pidx] = tmem;
-      pidx += 1;
-    }
-  }
-
-  /* how many threads are in use */
-  unsigned puse = pidx;
-
-  /* wait for all threads to come back */
-  while (puse > 0) {
-    /* join threads and check if one came 
-      back with a solution */
-    for (unsigned pi = 0; pi < pidx; ++pi) {
-      if (pact[pi] == false) {
-        continue;
-      }
-      /* handle thread */
-      pthread_t *thrd = &pool[pi];
-      unsigned *tmem = smem[pi];
-      if (solve_join(thrd, pi, grid, &sfnd, tmem)) {
-        /* thread came back */
-        puse -= 1;
-        pact[pi] = false;
-        free(tmem);
-      }
-    }
-    /* wait a bit */
-    usleep(1000);
-  }
-
-  /* stop here */
-  return sfnd;
-}
-
-/**
- * sudoku solver entrypoint
- *
- * @param  grid the sudoku grid
- * @param  use_threads whenever to use threaded or not
- * @return      true if a complete solution was found, false otherwise
- */
-static inline bool solve_puzzle (
-  unsigned grid[],
-  bool use_threads
-) {
-  assert(grid != 0);
-  /* start xxx (badword on github) */
-  if (use_threads) {
-    /* multi-threaded */
-    return find_solution_mt(grid);
-  }
-  /* single threaded */
-  return find_solution_st(grid);
+  return res;
 }
 
 /**
@@ -423,7 +88,7 @@ static inline bool solve_puzzle (
  * @param out
  */
 static void print_puzzle_fancy (
-  unsigned grid[],
+  sud_cell grid[],
   FILE *out
 ) {
   assert(grid != 0);
@@ -485,7 +150,7 @@ static void print_puzzle_fancy (
  * @param out  output-file
  */
 static void print_puzzle (
-  unsigned grid[], 
+  sud_cell grid[], 
   FILE *out,
   bool fancy
 ) {
@@ -494,14 +159,15 @@ static void print_puzzle (
 
   if (!fancy) {
     /* simple output format used by @German */
-    unsigned col = 0;
+    char buf[(9 * 10)];
+    unsigned pos = 0;
     for (unsigned idx = 0; idx < (9*9); ++idx) {
-      fprintf(out, "%u", grid[idx]);
-      if (col++ > 7) {
-        fputs("\n", out);
-        col = 0;
+      buf[pos++] = '0' + grid[idx];
+      if (idx % 9 == 8) {
+        buf[pos++] = '\n';
       }
     }
+    fwrite(buf, 1, pos, out);
   } else {
     print_puzzle_fancy(grid, out);
   }
@@ -509,77 +175,54 @@ static void print_puzzle (
   fputs("\n", out);
 }
 
+/**
+ * prints the grid as a single line, used in batch mode
+ *
+ * @param grid the sudoku grid
+ * @param out  output-file
+ */
+static void print_puzzle_line (
+  sud_cell grid[],
+  FILE *out
+) {
+  assert(grid != 0);
+  assert(out != 0);
+  char buf[(9 * 9) + 1];
+  for (unsigned idx = 0; idx < (9*9); ++idx) {
+    buf[idx] = '0' + grid[idx];
+  }
+  buf[9 * 9] = '\n';
+  fwrite(buf, 1, sizeof(buf), out);
+}
+
 /**
  * reads the input grid
  *
+ * @param ctx  the solver (parser)
  * @param grid
  * @param inp
  */
 static void read_puzzle_input (
-  unsigned grid[],
+  struct sud_ctx *ctx,
+  sud_cell grid[],
   FILE *inp
 ) {
+  assert(ctx != 0);
   assert(grid != 0);
   assert(inp != 0);
-  /* for error reporting */
-  unsigned rows[9][9] = {{0}};
-  unsigned cols[9][9] = {{0}};
-  bool grps[9][9] = {{false}};
+  char buf[(9 * 9)];
   unsigned col = 0;
   unsigned row = 0;
 
   for (unsigned idx = 0; idx < (9 * 9); ++idx) {
-    char chr = fgetc(inp);
+    int chr = fgetc(inp);
     if (chr == EOF) {
       whops(
         "premature end of input in row %u and column %u",
         row + 1, col + 1
       );
     }
-    if (chr != ' ') {
-      if (chr < '1' || chr > '9') {
-        /* out of bounds */
-        whops(
-          "invalid value `%c` (%i) in row %u and column %u",
-          chr, chr, row + 1, col + 1
-        );
-      }
-      /* get unsigned number from character */
-      unsigned val = chr - '0';
-      unsigned off = val - 1;
-      /* check if value is unique in current row */
-      if (rows[row][off]) {
-        whops(
-          "duplicate value %u in row %u (column %u)"
-          " - value already seen in column %u",
-          val, row + 1, col + 1,
-          rows[row][off] + 1
-        );
-      }
-      /* check if value is unique in current column */
-      if (cols[col][off]) {
-        whops(
-          "duplicate value %u in column %u (row %u)"
-          " - value already seen in row %u",
-          val, col + 1, row + 1,
-          cols[col][off] + 1
-        );
-      }
-      /* check if value is unique in current 3*3 group */
-      unsigned grp = row / 3 * 3 + col / 3;
-      if (grps[grp][off]) {
-        whops(
-          "duplicate value %u in group %u "
-          "(row %u and column %u)",
-          val, grp + 1, row + 1, col + 1
-        );
-      }
-      /* store given information */
-      grid[idx] = val;
-      rows[row][off] = col;
-      cols[col][off] = row;
-      grps[grp][off] = true;
-    }
+    buf[idx] = chr;
     if (col++ == 8) {
       /* line is complete */
       chr = fgetc(inp);
@@ -593,6 +236,212 @@ static void read_puzzle_input (
       row += 1;
     }
   }
+
+  size_t used;
+  if (sud_parse(ctx, grid, buf, (9 * 9), &used) != SUD_OK) {
+    whops("%s", sud_message(ctx));
+  }
+}
+
+/**
+ * reads the next grid in batch mode. a grid is either
+ * given as 9 lines with 9 characters each or as a
+ * single line with 81 characters. empty lines between
+ * grids are skipped
+ *
+ * @param  ctx  the solver (parser)
+ * @param  grid
+ * @param  inp
+ * @return      false if the end of input was reached
+ */
+static bool read_puzzle_batch (
+  struct sud_ctx *ctx,
+  sud_cell grid[],
+  FILE *inp
+) {
+  assert(ctx != 0);
+  assert(grid != 0);
+  assert(inp != 0);
+  /* 9 lines with "\r\n" + NUL, enough for one line with 81 */
+  char buf[9 * (9 + 2) + 1];
+  size_t len = 0;
+  size_t used;
+
+  for (;;) {
+    if (!fgets(buf + len, sizeof(buf) - len, inp)) {
+      if (len == 0) {
+        /* end of input */
+        return false;
+      }
+      /* message of the incomplete grid */
+      whops("%s", sud_message(ctx));
+    }
+    len += strlen(buf + len);
+    const int res = sud_parse(ctx, grid, buf, len, &used);
+    if (res == SUD_OK) {
+      return true;
+    }
+    if (res != SUD_MORE) {
+      whops("%s", sud_message(ctx));
+    }
+    /* drop empty lines, keep the rows read so far */
+    memmove(buf, buf + used, len - used);
+    len -= used;
+  }
+}
+
+/**
+ * batch mode, solves grids until the end of input and
+ * prints one line per grid in input order
+ *
+ * @param ctx the solver
+ * @param inp
+ * @param out
+ */
+static void solve_batch (
+  struct sud_ctx *ctx,
+  FILE *inp,
+  FILE *out
+) {
+  assert(inp != 0);
+  assert(out != 0);
+  /* large stdio buffers, must be set before any I/O */
+  static char ibuf[1 << 16];
+  static char obuf[1 << 16];
+  setvbuf(inp, ibuf, _IOFBF, sizeof(ibuf));
+  setvbuf(out, obuf, _IOFBF, sizeof(obuf));
+
+  sud_cell grid[(9 * 9)];
+  while (read_puzzle_batch(ctx, grid, inp)) {
+    if (solve_puzzle(ctx, grid) == SUD_OK) {
+      print_puzzle_line(grid, out);
+    } else {
+      fputs("no solution\n", out);
+    }
+  }
+
+  fflush(out);
+}
+
+/**
+ * returns a monotonic timestamp in microseconds
+ *
+ * @return the timestamp
+ */
+static double bench_clock ()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/**
+ * compares two timings, used with qsort
+ *
+ * @param  a
+ * @param  b
+ * @return   <0, 0 or >0
+ */
+static int bench_cmp (
+  const void *a,
+  const void *b
+) {
+  const double x = *(const double *) a;
+  const double y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * benchmark mode, solves every grid file `reps` times after
+ * `warm` warmup runs and reports min/median/p99 wall time and
+ * search nodes per grid, optionally as csv too
+ *
+ * @param ctx  the solver
+ * @param opts program options
+ * @param out  output for the table
+ */
+static void run_bench (
+  struct sud_ctx *ctx,
+  const struct sopts *opts,
+  FILE *out
+) {
+  assert(opts != 0);
+  assert(out != 0);
+  if (opts->nfiles == 0) {
+    whops("benchmark mode requires grid files");
+  }
+
+  const char *name = opts->threads ? "ssud-mt" : "ssud-st";
+  const unsigned reps = opts->reps;
+  sud_cell (*grids)[9*9] = calloc(opts->nfiles, sizeof(*grids));
+  double *time = calloc(reps, sizeof(double));
+  if (!grids || !time) {
+    whops("unable to allocate benchmark memory");
+  }
+
+  /* load all grids once */
+  for (unsigned i = 0; i < opts->nfiles; ++i) {
+    FILE *inp = fopen(opts->files[i], "r");
+    if (!inp) {
+      whops("unable to open `%s`", opts->files[i]);
+    }
+    read_puzzle_input(ctx, grids[i], inp);
+    fclose(inp);
+  }
+
+  FILE *csv = 0;
+  if (opts->csv) {
+    csv = fopen(opts->csv, "w");
+    if (!csv) {
+      whops("unable to open `%s`", opts->csv);
+    }
+    fputs("engine,grid,reps,min_us,median_us,p99_us,nodes\n", csv);
+  }
+
+  fprintf(out, "%s, %u runs per grid (%u warmup)\n\n",
+    name, reps, opts->warm);
+  fprintf(out, "%-24s %12s %12s %12s %12s\n",
+    "grid", "min [us]", "median [us]", "p99 [us]", "nodes");
+
+  double total = 0;
+  for (unsigned i = 0; i < opts->nfiles; ++i) {
+    unsigned long nodes = 0;
+    for (unsigned run = 0; run < opts->warm + reps; ++run) {
+      sud_cell grid[(9 * 9)];
+      memcpy(grid, grids[i], sizeof(grid));
+      const double beg = bench_clock();
+      const int res = solve_puzzle(ctx, grid);
+      const double end = bench_clock();
+      if (res != SUD_OK) {
+        whops("no solution for `%s`", opts->files[i]);
+      }
+      if (run >= opts->warm) {
+        time[run - opts->warm] = end - beg;
+        total += end - beg;
+      }
+      nodes = sud_nodes(ctx);
+    }
+    qsort(time, reps, sizeof(double), bench_cmp);
+    const double min = time[0];
+    const double med = time[reps / 2];
+    const double p99 = time[(reps * 99 + 99) / 100 - 1];
+    fprintf(out, "%-24s %12.1f %12.1f %12.1f %12lu\n",
+      opts->files[i], min, med, p99, nodes);
+    if (csv) {
+      fprintf(csv, "%s,%s,%u,%.3f,%.3f,%.3f,%lu\n",
+        name, opts->files[i], reps, min, med, p99, nodes);
+    }
+  }
+
+  const unsigned long solves = (unsigned long) reps * opts->nfiles;
+  fprintf(out, "\n%lu solves in %.3f s, %.1f solves/s\n",
+    solves, total / 1e6, solves / (total / 1e6));
+
+  if (csv) {
+    fclose(csv);
+  }
+  free(time);
+  free(grids);
 }
 
 /**
@@ -609,8 +458,17 @@ static void parse_sopts (
 ) {
   assert(opts != 0);
   opts->threads = true;
+  opts->jobs = 0;
   opts->fancy = false;
   opts->help = false;
+  opts->batch = false;
+  opts->verbose = false;
+  opts->bench = false;
+  opts->reps = 0;
+  opts->warm = 1;
+  opts->csv = 0;
+  opts->files = 0;
+  opts->nfiles = 0;
 
   if (argc == 1) {
     /* no options passed */
@@ -622,10 +480,56 @@ static void parse_sopts (
       opts->threads = false;
       continue;
     }
+    if (strcmp(argv[i], "-j") == 0) {
+      if (i + 1 >= argc || atoi(argv[i + 1]) <= 0) {
+        whops("option -j requires a positive number");
+      }
+      opts->jobs = atoi(argv[++i]);
+      continue;
+    }
     if (strcmp(argv[i], "-f") == 0) {
       opts->fancy = true;
       continue;
     }
+    if (strcmp(argv[i], "-b") == 0) {
+      opts->batch = true;
+      continue;
+    }
+    if (strcmp(argv[i], "-v") == 0) {
+      opts->verbose = true;
+      continue;
+    }
+    if (strcmp(argv[i], "-B") == 0) {
+      if (i + 1 >= argc || atoi(argv[i + 1]) <= 0) {
+        whops("option -B requires a positive number");
+      }
+      opts->bench = true;
+      opts->reps = atoi(argv[++i]);
+      continue;
+    }
+    if (strcmp(argv[i], "-w") == 0) {
+      if (i + 1 >= argc || atoi(argv[i + 1]) < 0) {
+        whops("option -w requires a number");
+      }
+      opts->warm = atoi(argv[++i]);
+      continue;
+    }
+    if (strcmp(argv[i], "-o") == 0) {
+      if (i + 1 >= argc) {
+        whops("option -o requires a file name");
+      }
+      opts->csv = argv[++i];
+      continue;
+    }
+    if (argv[i][0] != '-') {
+      /* grid file, collected in place */
+      if (!opts->files) {
+        opts->files = &argv[i];
+      }
+      argv[opts->files - argv + opts->nfiles] = argv[i];
+      opts->nfiles += 1;
+      continue;
+    }
     if (strcmp(argv[i], "-h") == 0 ||
         strcmp(argv[i], "-?") == 0) {
       opts->help = true;
@@ -641,14 +545,21 @@ static void parse_sopts (
 static void print_usage ()
 {
   puts("usage:");
-  puts("\t./ssud [-s] [-f] [-h] input");
+  puts("\t./ssud [-s] [-j N] [-f] [-b] [-v] [-h] input");
+  puts("\t./ssud [-s] [-j N] -B N [-w N] [-o csv] grid...");
   puts("\noptions:");
   puts("\t-s\tenable single-threaded mode");
+  puts("\t-j N\tuse N worker threads (default: one per cpu)");
   puts("\t-f\tenable fancy output-format (UTF8 blocks on linux)");
+  puts("\t-b\tbatch mode, solves grids until end of input");
+  puts("\t  \t(9 lines or one line with 81 characters per grid)");
+  puts("\t-v\tprint search statistics to stderr");
+  puts("\t-B N\tbenchmark mode, solves each grid file N times");
+  puts("\t-w N\tbenchmark warmup runs per grid (default: 1)");
+  puts("\t-o csv\twrite benchmark results to a csv file");
   puts("\t-h\tshows this help");
   puts("");
 }
-
 /**
  * main entry point
  *
@@ -665,21 +576,48 @@ int main (int argc, char *argv[])
     return 0;
   }
 
-  /* read grid */
-  unsigned grid[(9 * 9)] = {0};
-  read_puzzle_input(grid, stdin);
-
-  if (opts.fancy) {
-    /* print input grid */
-    print_puzzle(grid, stdout, true);
+  /* workers are reused for every grid */
+  struct sud_conf conf = {
+    .threads = opts.threads,
+    .jobs = opts.jobs
+  };
+  struct sud_ctx *ctx;
+  const int res = sud_open(&ctx, &conf);
+  if (res != SUD_OK) {
+    whops("unable to create the solver: %s", sud_strerror(res));
   }
 
-  if (solve_puzzle(grid, opts.threads)) {
-    /* puzzle was solved, print output grid */
-    print_puzzle(grid, stdout, opts.fancy);
+  /* for the statistics */
+  const double beg = bench_clock();
+
+  if (opts.bench) {
+    /* timings per grid file */
+    run_bench(ctx, &opts, stdout);
+  } else if (opts.batch) {
+    /* one line per grid */
+    solve_batch(ctx, stdin, stdout);
   } else {
-    fputs("no solution\n", stdout);
+    /* read grid */
+    sud_cell grid[(9 * 9)] = {0};
+    read_puzzle_input(ctx, grid, stdin);
+
+    if (opts.fancy) {
+      /* print input grid */
+      print_puzzle(grid, stdout, true);
+    }
+
+    if (solve_puzzle(ctx, grid) == SUD_OK) {
+      /* puzzle was solved, print output grid */
+      print_puzzle(grid, stdout, opts.fancy);
+    } else {
+      fputs("no solution\n", stdout);
+    }
+  }
+
+  if (opts.verbose) {
+    sud_stats(ctx, stderr, bench_clock() - beg);
   }
 
+  sud_close(ctx);
   return 0;
 }
@@ -0,0 +1,5321 @@
+/**
+ * To the extent possible under law, the author(s) have dedicated
+ * all copyright and related and neighboring rights to this software
+ * to the public domain worldwide. This software is distributed
+ * without any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ *
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+#if defined(__linux__)
+  /* sched_getaffinity and pthread_setaffinity_np */
+  #define _GNU_SOURCE
+#endif
+
+#include <stdlib.h> /* aligned_alloc, calloc, free, qsort */
+#include <stdio.h> /* snprintf */
+#include <stdint.h> /* uint32_t */
+#include <stdalign.h> /* alignas */
+#include <stdbool.h> /* bool, true false */
+#include <string.h> /* memcpy */
+#include <pthread.h> /* pthread ... */
+#include <assert.h> /* assert */
+#include <time.h> /* clock_gettime */
+#include <stdatomic.h> /* atomic_uint, atomic_bool */
+#include <unistd.h> /* sysconf */
+
+#if defined(__linux__)
+  #include <sched.h> /* sched_getaffinity, cpu_set_t */
+  #include <dirent.h> /* opendir, readdir */
+#endif
+
+#include "sudoku.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  /* kernels are built for several instruction sets and
+    chosen at runtime, see `skern` */
+  #define SDISPATCH
+  #include <immintrin.h> /* sse2, sse4.1 and avx2 intrinsics */
+  #define STARGET(isa) __attribute__((target(isa)))
+#endif
+
+/* the body of a kernel, inlined into each of its variants */
+#define SKERNEL static inline __attribute__((always_inline))
+
+/* used to indicate that "no index" was found */
+#define NOINDEX (SCELLS+1)
+
+/* all candidates, this is a bitmask with bit 1 to SSIZE set to 1 */
+#define ALLCANDS (((sud_mask) 1 << (SSIZE + 1)) - 2)
+
+/* capacity of a worker deque */
+#define SDEQUE 256
+
+/* cache line size, shared data is aligned to it */
+#define SLINE 64
+
+/* exact cover matrix dimensions */
+#define DLX_COLS (4*SCELLS)
+#define DLX_ROWS (SCELLS*SSIZE)
+#define DLX_NODES (1 + DLX_COLS + 4 * DLX_ROWS)
+
+/* grids per generated puzzle before the target clue count is given up */
+#define SGENTRIES 1000
+
+/* puzzles a generator may run ahead of the next one to emit, per thread */
+#define SGENAHEAD 2
+
+/* search nodes between two checks of the budgets */
+#define SBUDGET 64
+
+/* bit 1 to SSIZE, 32 bits are enough up to 25*25 */
+#if SSIZE < 16
+  typedef uint16_t sud_mask;
+#else
+  typedef uint32_t sud_mask;
+#endif
+
+/* an eliminated candidate is stored as slot << ESHIFT | number */
+#define ESHIFT 5
+
+/**
+ * a branch of the search: a slot, the candidates that are
+ * still to be tried and the trails after propagation
+ */
+struct sframe {
+  uint16_t idx;
+  sud_mask cans;
+  uint16_t tlen;
+  uint16_t elen;
+};
+
+/**
+ * search state
+ *
+ * the grid plus one mask of seen numbers for each row,
+ * column and group. the masks are updated whenever
+ * a number is placed or removed, so candidates can be
+ * looked up without scanning the grid. the trails record
+ * what the search changed, so it can be reverted.
+ */
+struct sstate {
+  /* the sudoku grid */
+  alignas(SLINE) sud_cell grid[SCELLS];
+  /* seen numbers per row */
+  sud_mask rows[SSIZE];
+  /* seen numbers per column */
+  sud_mask cols[SSIZE];
+  /* seen numbers per group */
+  sud_mask grps[SSIZE];
+  /* candidates eliminated by propagation, per slot */
+  sud_mask excl[SCELLS];
+  /* slots filled by the search, in order */
+  uint16_t trail[SCELLS];
+  /* eliminated candidates (slot << ESHIFT | number), in order */
+  uint16_t etrail[SCELLS*SSIZE];
+  /* length of both trails */
+  unsigned tlen;
+  unsigned elen;
+  /* open branches of `find_solution_st`, at most one per slot */
+  struct sframe frames[SCELLS];
+};
+
+#if SBOX == 3
+/**
+ * bitboard state, one candidate board per digit. a board has
+ * one word per band (three rows of nine slots), slot `idx` is
+ * bit `idx % 27` of word `idx / 27`. states are copied on
+ * every branch, there is nothing to undo
+ */
+struct sbits {
+  /* candidates per digit */
+  uint32_t cand[9][3];
+  /* placed slots per digit */
+  uint32_t done[9][3];
+  /* empty slots */
+  uint32_t open[3];
+};
+#endif
+
+/**
+ * compact copy of a search state, used for queued tasks
+ * and results. only the grid and the unit masks are kept,
+ * the eliminations are found again by `propagate`
+ */
+struct stask {
+  alignas(SLINE) sud_cell grid[SCELLS];
+  sud_mask rows[SSIZE];
+  sud_mask cols[SSIZE];
+  sud_mask grps[SSIZE];
+};
+
+/**
+ * exact cover matrix for dancing links. node 0 is the root,
+ * followed by the column headers and 4 nodes per matrix row.
+ * all links are indices into the same preallocated arrays
+ */
+struct sdlx {
+  /* left, right, up and down links */
+  uint16_t l[DLX_NODES];
+  uint16_t r[DLX_NODES];
+  uint16_t u[DLX_NODES];
+  uint16_t d[DLX_NODES];
+  /* column header of a node */
+  uint16_t c[DLX_NODES];
+  /* matrix row of a node (slot * SSIZE + number - 1) */
+  uint16_t row[DLX_NODES];
+  /* number of rows per column */
+  uint16_t size[DLX_COLS + 1];
+  /* first node of each matrix row */
+  uint16_t rown[DLX_ROWS];
+  /* selected matrix rows */
+  uint16_t sol[SCELLS];
+  unsigned nsol;
+};
+
+/**
+ * returns a monotonic timestamp in nanoseconds
+ *
+ * @return the timestamp
+ */
+static inline uint64_t mono_clock ()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * search statistics, only collected when compiled
+ * with -DSSTATS, otherwise all STATS_ macros are no-ops
+ */
+#if defined(SSTATS)
+struct sstats {
+  /* visited nodes */
+  unsigned long nodes;
+  /* numbers tried (descents) */
+  unsigned long tries;
+  /* numbers taken back */
+  unsigned long backs;
+  /* current and maximum depth */
+  unsigned depth;
+  unsigned maxdep;
+  /* branching factor (0-SSIZE candidates) per depth */
+  unsigned long branch[SCELLS+1][SSIZE+1];
+  /* time spent in find_slot, nanoseconds */
+  uint64_t slot;
+};
+
+/* statistics of the current thread, set on every call, workers
+  use their pool slot */
+static _Thread_local struct sstats *sstats;
+
+#define STATS_CLOCK(var) const uint64_t var = mono_clock()
+#define STATS_SLOT(beg) (sstats->slot += mono_clock() - (beg))
+#define STATS_ROOT() (sstats->depth = 0)
+#define STATS_NODE() (sstats->nodes += 1)
+#define STATS_BRANCH(cnt) (sstats->branch[sstats->depth][(cnt)] += 1)
+#define STATS_DOWN() do {                 \
+  sstats->tries += 1;                     \
+  if (++sstats->depth > sstats->maxdep) { \
+    sstats->maxdep = sstats->depth;       \
+  }                                       \
+} while (0)
+#define STATS_UP() do { \
+  sstats->backs += 1;   \
+  sstats->depth -= 1;   \
+} while (0)
+#else
+#define STATS_CLOCK(var) ((void) 0)
+#define STATS_SLOT(beg) ((void) 0)
+#define STATS_ROOT() ((void) 0)
+#define STATS_NODE() ((void) 0)
+#define STATS_BRANCH(cnt) ((void) 0)
+#define STATS_DOWN() ((void) 0)
+#define STATS_UP() ((void) 0)
+#endif
+
+/**
+ * double ended task queue of a worker. the owner pushes and
+ * pops at the bottom, idle workers steal from the top
+ */
+struct sdeque {
+  /* one line per deque, workers lock different deques */
+  alignas(SLINE) pthread_mutex_t mtx;
+  /* position of the oldest task */
+  unsigned top;
+  /* number of queued tasks */
+  unsigned len;
+  /* ring buffer with SDEQUE tasks */
+  struct stask *task;
+  /* the pool of the owner */
+  struct spool *pool;
+};
+
+/**
+ * persistent worker pool
+ */
+struct spool {
+  /* number of workers */
+  unsigned size;
+  /* worker threads and how many of them were started */
+  pthread_t *thrd;
+  unsigned running;
+  /* cpu per worker, 0 if they are not pinned */
+  unsigned *cpus;
+  /* workers that set up their deque, and if one of them failed */
+  unsigned ready;
+  bool nomem;
+  /* one deque per worker */
+  struct sdeque *deqs;
+  /* protects sleeping, the result and shutdown */
+  pthread_mutex_t mtx;
+  /* signaled when a task was queued */
+  pthread_cond_t work;
+  /* signaled when the current solve is complete */
+  pthread_cond_t done;
+  /* number of sleeping workers, the counters are
+    written per task and get their own line */
+  alignas(SLINE) atomic_uint idle;
+  /* queued tasks in all deques */
+  atomic_uint queued;
+  /* queued and running tasks of the current solve */
+  atomic_uint pending;
+  /* search nodes of the current solve */
+  atomic_ulong nodes;
+  /* solutions of the current solve and the limit to stop at,
+    written before the first task is queued */
+  atomic_ulong count;
+  unsigned long limit;
+  /* true if a solution was found, the status is read
+    on every node and gets its own line as well */
+  alignas(SLINE) atomic_bool found;
+  /* true if running searches should give up */
+  atomic_bool stop;
+  /* true if they gave up because a budget ran out */
+  atomic_bool spent;
+  /* nodes counted against the budget of the current solve */
+  atomic_ulong used;
+  /* node budget and deadline (see `mono_clock`) of the
+    current solve, 0 for none */
+  unsigned long budget;
+  uint64_t deadline;
+  /* branching heuristic of the searches */
+  enum sud_heur heur;
+#if defined(SSTATS)
+  /* statistics per worker */
+  alignas(SLINE) struct sstats *stats;
+#endif
+  /* the solution */
+  struct stask result;
+  /* true if the workers should stop */
+  bool quit;
+};
+
+/**
+ * solver context, everything a call needs is allocated once
+ */
+struct sud_ctx {
+  /* search state of the bitmask engine */
+  struct sstate st;
+  /* exact cover matrix of the dlx engine */
+  struct sdlx dx;
+  /* the configuration */
+  struct sud_conf conf;
+  /* the worker pool, no workers if single threaded */
+  struct spool pool;
+  /* search nodes of the last call */
+  unsigned long nodes;
+  /* search memory of the canonical form, with a cache only */
+  struct scanon *canon;
+#if defined(SSTATS)
+  /* statistics of the calling threads */
+  struct sstats stats;
+#endif
+  /* message of the last error */
+  char msg[160];
+};
+
+/* search nodes visited by the current thread */
+static _Thread_local unsigned long snodes;
+
+/* search nodes of the current thread at its last budget check */
+static _Thread_local unsigned long scheck;
+
+/* partial transform of the canonical form, see `canon_grid` */
+struct scanon;
+
+/**
+ * error handler function ;) stores the message
+ * in the context and returns the status code
+ */
+#define whops(ctx, res, ...) do {                        \
+  snprintf((ctx)->msg, sizeof((ctx)->msg), __VA_ARGS__); \
+  return (res);                                          \
+} while (0)
+
+/* row, column and group of a index */
+#define IDX_ROW(idx) ((idx) / SSIZE)
+#define IDX_COL(idx) ((idx) % SSIZE)
+#define IDX_GRP(idx) (IDX_ROW(idx) / SBOX * SBOX + IDX_COL(idx) / SBOX)
+/**
+ * places a number in the grid and marks it as
+ * seen in the row, column and group masks
+ *
+ * @param st  the search state
+ * @param idx the index in the grid
+ * @param num the number to be placed
+ */
+static inline void place_number (
+  struct sstate *st,
+  unsigned idx,
+  unsigned num
+) {
+  assert(st != 0);
+  assert(st->grid[idx] == 0);
+  const sud_mask bit = 1 << num;
+  st->grid[idx] = num;
+  st->rows[IDX_ROW(idx)] |= bit;
+  st->cols[IDX_COL(idx)] |= bit;
+  st->grps[IDX_GRP(idx)] |= bit;
+}
+
+/**
+ * removes a number placed with `place_number`.
+ * a number can only be seen once per row, column and
+ * group, so clearing its bit restores the previous masks
+ *
+ * @param st  the search state
+ * @param idx the index in the grid
+ */
+static inline void clear_number (
+  struct sstate *st,
+  unsigned idx
+) {
+  assert(st != 0);
+  assert(st->grid[idx] != 0);
+  const sud_mask bit = ~(1 << st->grid[idx]);
+  st->grid[idx] = 0;
+  st->rows[IDX_ROW(idx)] &= bit;
+  st->cols[IDX_COL(idx)] &= bit;
+  st->grps[IDX_GRP(idx)] &= bit;
+}
+
+/**
+ * builds the search state for the given grid
+ *
+ * @param st   the search state
+ * @param grid the sudoku grid
+ */
+static void init_state (
+  struct sstate *st,
+  const sud_cell grid[]
+) {
+  assert(st != 0);
+  assert(grid != 0);
+  memset(st, 0, sizeof(*st));
+  for (unsigned idx = 0; idx < SCELLS; ++idx) {
+    if (grid[idx]) {
+      place_number(st, idx, grid[idx]);
+    }
+  }
+}
+
+/**
+ * returns the candidates for the given index
+ *
+ * @param  st  the search state
+ * @param  idx the index in the grid
+ * @param  len number of candidates (output)
+ * @return     the candidate bitmask (bit 1 to SSIZE)
+ */
+static inline sud_mask find_cans (
+  const struct sstate *st,
+  unsigned idx,
+  unsigned *len
+) {
+  assert(st != 0);
+  const sud_mask res = ~(
+    st->rows[IDX_ROW(idx)] |
+    st->cols[IDX_COL(idx)] |
+    st->grps[IDX_GRP(idx)] |
+    st->excl[idx]
+  ) & ALLCANDS;
+  if (len) {
+    *len = __builtin_popcount(res);
+  }
+  return res;
+}
+
+/**
+ * places a number and records it on the trail
+ *
+ * @param st  the search state
+ * @param idx the index in the grid
+ * @param num the number to be placed
+ */
+static inline void push_number (
+  struct sstate *st,
+  unsigned idx,
+  unsigned num
+) {
+  assert(st->tlen < SCELLS);
+  place_number(st, idx, num);
+  st->trail[st->tlen++] = idx;
+}
+
+/**
+ * eliminates candidates from a slot and records
+ * them on the trail
+ *
+ * @param  st  the search state
+ * @param  idx the index in the grid
+ * @param  msk the candidates to be eliminated
+ * @return     true if a candidate was eliminated
+ */
+static inline bool elim_cans (
+  struct sstate *st,
+  unsigned idx,
+  sud_mask msk
+) {
+  assert(st != 0);
+  if (st->grid[idx]) {
+    /* filled slot */
+    return false;
+  }
+  msk &= find_cans(st, idx, 0);
+  if (msk == 0) {
+    /* nothing to do */
+    return false;
+  }
+  st->excl[idx] |= msk;
+  while (msk) {
+    assert(st->elen < SCELLS*SSIZE);
+    st->etrail[st->elen++] = (idx << ESHIFT) | __builtin_ctz(msk);
+    msk &= msk - 1;
+  }
+  return true;
+}
+
+/**
+ * reverts the trail to the given lengths
+ *
+ * @param st   the search state
+ * @param tlen length of the placement trail
+ * @param elen length of the elimination trail
+ */
+static inline void undo_trail (
+  struct sstate *st,
+  unsigned tlen,
+  unsigned elen
+) {
+  assert(st != 0);
+  while (st->tlen > tlen) {
+    clear_number(st, st->trail[--st->tlen]);
+  }
+  while (st->elen > elen) {
+    const unsigned ent = st->etrail[--st->elen];
+    st->excl[ent >> ESHIFT] &= ~((sud_mask) 1 << (ent & ((1 << ESHIFT) - 1)));
+  }
+}
+
+/**
+ * returns the slot at the given position of a unit
+ *
+ * @param  unt the unit: rows first, then columns, then groups
+ * @param  pos the position in the unit
+ * @return     the index in the grid
+ */
+static inline unsigned unit_slot (
+  unsigned unt,
+  unsigned pos
+) {
+  if (unt < SSIZE) {
+    return unt * SSIZE + pos;
+  }
+  if (unt < SSIZE * 2) {
+    return pos * SSIZE + (unt - SSIZE);
+  }
+  unt -= SSIZE * 2;
+  return
+    (unt / SBOX * SBOX + pos / SBOX) * SSIZE +
+    (unt % SBOX * SBOX + pos % SBOX);
+}
+
+/**
+ * fills in naked and hidden singles and eliminates locked
+ * candidates (pointing and claiming) until nothing changes
+ *
+ * @param  st the search state
+ * @return    false if a contradiction was found
+ */
+SKERNEL bool propagate (
+  struct sstate *st
+) {
+  assert(st != 0);
+  sud_mask cans[SCELLS];
+  bool chg;
+
+  do {
+    chg = false;
+
+    /* naked singles, placed right away */
+    for (unsigned idx = 0; idx < SCELLS; ++idx) {
+      if (st->grid[idx] == 0) {
+        unsigned len;
+        sud_mask msk = find_cans(st, idx, &len);
+        if (len == 0) {
+          /* no candidates */
+          return false;
+        }
+        if (len == 1) {
+          push_number(st, idx, __builtin_ctz(msk));
+          chg = true;
+        }
+      }
+    }
+    if (chg) {
+      continue;
+    }
+
+    for (unsigned idx = 0; idx < SCELLS; ++idx) {
+      cans[idx] = st->grid[idx] ? 0 : find_cans(st, idx, 0);
+    }
+
+    /* hidden singles, a number fits in one slot of a unit */
+    for (unsigned unt = 0; unt < SSIZE * 3; ++unt) {
+      sud_mask once = 0;
+      sud_mask more = 0;
+      for (unsigned pos = 0; pos < SSIZE; ++pos) {
+        const sud_mask msk = cans[unit_slot(unt, pos)];
+        more |= once & msk;
+        once |= msk;
+      }
+      const sud_mask seen =
+        unt < SSIZE ? st->rows[unt] :
+        unt < SSIZE * 2 ? st->cols[unt - SSIZE] :
+        st->grps[unt - SSIZE * 2];
+      if (((once | seen) & ALLCANDS) != ALLCANDS) {
+        /* a number has no slot left */
+        return false;
+      }
+      sud_mask hid = once & ~more & ~seen;
+      while (hid) {
+        const unsigned num = __builtin_ctz(hid);
+        hid &= hid - 1;
+        unsigned pos = 0;
+        while (!(cans[unit_slot(unt, pos)] & (1 << num))) {
+          pos += 1;
+        }
+        const unsigned idx = unit_slot(unt, pos);
+        if (st->grid[idx] || !(find_cans(st, idx, 0) & (1 << num))) {
+          /* slot was taken by another single */
+          return false;
+        }
+        push_number(st, idx, num);
+        chg = true;
+      }
+    }
+    if (chg) {
+      continue;
+    }
+
+    /* locked candidates, using the candidates of each
+      SBOX slot segment of a row or column */
+    sud_mask rseg[SSIZE][SBOX];
+    sud_mask cseg[SSIZE][SBOX];
+    for (unsigned i = 0; i < SSIZE; ++i) {
+      for (unsigned s = 0; s < SBOX; ++s) {
+        rseg[i][s] = 0;
+        cseg[i][s] = 0;
+        for (unsigned k = 0; k < SBOX; ++k) {
+          rseg[i][s] |= cans[i * SSIZE + s * SBOX + k];
+          cseg[i][s] |= cans[(s * SBOX + k) * SSIZE + i];
+        }
+      }
+    }
+    for (unsigned i = 0; i < SSIZE; ++i) {
+      /* first line of the band/stack */
+      const unsigned band = i / SBOX * SBOX;
+      for (unsigned s = 0; s < SBOX; ++s) {
+        /* other lines of the group and other groups of the line */
+        sud_mask rgrp = 0;
+        sud_mask rlin = 0;
+        sud_mask cgrp = 0;
+        sud_mask clin = 0;
+        for (unsigned o = 0; o < SBOX; ++o) {
+          if (band + o != i) {
+            rgrp |= rseg[band + o][s];
+            cgrp |= cseg[band + o][s];
+          }
+          if (o != s) {
+            rlin |= rseg[i][o];
+            clin |= cseg[i][o];
+          }
+        }
+        sud_mask msk;
+        /* pointing: only in this row of the group */
+        msk = rseg[i][s] & ~rgrp;
+        for (unsigned o = 0; msk && o < SBOX; ++o) {
+          for (unsigned k = 0; o != s && k < SBOX; ++k) {
+            chg |= elim_cans(st, i * SSIZE + o * SBOX + k, msk);
+          }
+        }
+        /* claiming: only in this group of the row */
+        msk = rseg[i][s] & ~rlin;
+        for (unsigned o = 0; msk && o < SBOX; ++o) {
+          for (unsigned k = 0; band + o != i && k < SBOX; ++k) {
+            chg |= elim_cans(st, (band + o) * SSIZE + s * SBOX + k, msk);
+          }
+        }
+        /* pointing: only in this column of the group */
+        msk = cseg[i][s] & ~cgrp;
+        for (unsigned o = 0; msk && o < SBOX; ++o) {
+          for (unsigned k = 0; o != s && k < SBOX; ++k) {
+            chg |= elim_cans(st, (o * SBOX + k) * SSIZE + i, msk);
+          }
+        }
+        /* claiming: only in this group of the column */
+        msk = cseg[i][s] & ~clin;
+        for (unsigned o = 0; msk && o < SBOX; ++o) {
+          for (unsigned k = 0; band + o != i && k < SBOX; ++k) {
+            chg |= elim_cans(st, (s * SBOX + k) * SSIZE + band + o, msk);
+          }
+        }
+      }
+    }
+  } while (chg);
+
+  return true;
+}
+
+/**
+ * `propagate` in plain C
+ */
+static bool propagate_generic (
+  struct sstate *st
+) {
+  return propagate(st);
+}
+
+#if defined(SDISPATCH)
+/**
+ * `propagate` with popcnt
+ */
+STARGET("popcnt") static bool propagate_popcnt (
+  struct sstate *st
+) {
+  return propagate(st);
+}
+
+/**
+ * `propagate` with avx2 and bmi, the compiler
+ * vectorizes the candidate loops
+ */
+STARGET("avx2,bmi,popcnt") static bool propagate_avx2 (
+  struct sstate *st
+) {
+  return propagate(st);
+}
+#endif
+
+#if defined(SDISPATCH) && SBOX == 3
+/**
+ * returns a index in the grid with the least possibilities,
+ * 8 slots of a row at a time
+ *
+ * @param  st   the search state
+ * @param  slot candidate bitmask output
+ * @return      the index or NOINDEX if no index was found
+ */
+SKERNEL STARGET("sse4.1,popcnt") unsigned find_slot_vec (
+  const struct sstate *st,
+  sud_mask *slot
+) {
+  assert(st != 0);
+  assert(slot != 0);
+  unsigned idx = NOINDEX;
+  unsigned prv = 10;
+  sud_mask res = 0;
+  /* bit count of each nibble */
+  const __m128i nct = _mm_setr_epi8(
+    0, 1, 1, 2, 1, 2, 2, 3,
+    1, 2, 2, 3, 2, 3, 3, 4
+  );
+  const __m128i nib = _mm_set1_epi8(0x0F);
+  const __m128i low = _mm_set1_epi16(0x00FF);
+  const __m128i all = _mm_set1_epi16(ALLCANDS);
+  const __m128i nul = _mm_setzero_si128();
+  /* the first 8 columns of every row, the 9th is scalar */
+  const __m128i cols = _mm_setr_epi16(
+    st->cols[0], st->cols[1], st->cols[2], st->cols[3],
+    st->cols[4], st->cols[5], st->cols[6], st->cols[7]
+  );
+  __m128i grps = nul;
+  for (unsigned row = 0; row < 9; ++row) {
+    const sud_cell *cells = &st->grid[row * 9];
+    if (row % 3 == 0) {
+      /* next band of groups */
+      const sud_mask *g = &st->grps[row];
+      grps = _mm_setr_epi16(
+        g[0], g[0], g[0], g[1],
+        g[1], g[1], g[2], g[2]
+      );
+    }
+    /* candidates of 8 slots */
+    const __m128i excl = _mm_loadu_si128(
+      (const __m128i *) &st->excl[row * 9]
+    );
+    const __m128i seen = _mm_or_si128(
+      _mm_or_si128(_mm_set1_epi16(st->rows[row]), excl),
+      _mm_or_si128(cols, grps)
+    );
+    const __m128i cans = _mm_andnot_si128(seen, all);
+    /* count bits per byte, then add both bytes */
+    __m128i cnt = _mm_add_epi8(
+      _mm_shuffle_epi8(nct, _mm_and_si128(cans, nib)),
+      _mm_shuffle_epi8(nct, _mm_and_si128(_mm_srli_epi16(cans, 4), nib))
+    );
+    cnt = _mm_add_epi16(
+      _mm_and_si128(cnt, low),
+      _mm_srli_epi16(cnt, 8)
+    );
+    /* filled slots get the highest count */
+    const __m128i nums = _mm_cvtepu8_epi16(
+      _mm_loadl_epi64((const __m128i *) cells)
+    );
+    cnt = _mm_or_si128(cnt,
+      _mm_xor_si128(_mm_cmpeq_epi16(nums, nul), _mm_cmpeq_epi16(nul, nul))
+    );
+    /* lowest count and its (first) position */
+    const unsigned min = _mm_cvtsi128_si32(_mm_minpos_epu16(cnt));
+    const unsigned len = min & 0xFFFF;
+    if (len < prv) {
+      /* better candidate */
+      prv = len;
+      idx = row * 9 + (min >> 16);
+      res = find_cans(st, idx, 0);
+    }
+    if (cells[8] == 0 && prv > 1) {
+      /* 9th slot */
+      unsigned len = 0;
+      sud_mask msk = find_cans(st, row * 9 + 8, &len);
+      if (len < prv) {
+        prv = len;
+        res = msk;
+        idx = row * 9 + 8;
+      }
+    }
+    if (prv <= 1) {
+      /* best possible result */
+      break;
+    }
+  }
+  *slot = res;
+  return idx;
+}
+
+/**
+ * `find_slot_vec` with sse4.1
+ */
+STARGET("sse4.1,popcnt") static unsigned find_slot_sse4 (
+  const struct sstate *st,
+  sud_mask *slot
+) {
+  return find_slot_vec(st, slot);
+}
+
+/**
+ * `find_slot_vec` with avx2 (vex encoded)
+ */
+STARGET("avx2,bmi,popcnt") static unsigned find_slot_avx2 (
+  const struct sstate *st,
+  sud_mask *slot
+) {
+  return find_slot_vec(st, slot);
+}
+#endif
+
+/**
+ * returns a index in the grid with the least possibilities
+ *
+ * @param  st   the search state
+ * @param  slot candidate bitmask output
+ * @return      the index or NOINDEX if no index was found
+ */
+SKERNEL unsigned find_slot (
+  const struct sstate *st,
+  sud_mask *slot
+) {
+  assert(st != 0);
+  assert(slot != 0);
+  unsigned idx = NOINDEX;
+  unsigned prv = SSIZE + 1;
+  sud_mask res = 0;
+  for (unsigned i = 0; i < SCELLS; ++i) {
+    if (st->grid[i] == 0) {
+      /* empty slot */
+      unsigned len = 0;
+      sud_mask msk;
+      msk = find_cans(st, i, &len);
+      if (len < prv) {
+        /* better candidate */
+        prv = len;
+        res = msk;
+        idx = i;
+        if (len <= 1) {
+          /* best possible result */
+          break;
+        }
+      }
+    }
+  }
+  *slot = res;
+  return idx;
+}
+
+/**
+ * `find_slot` in plain C
+ */
+static unsigned find_slot_generic (
+  const struct sstate *st,
+  sud_mask *slot
+) {
+  return find_slot(st, slot);
+}
+
+#if defined(SDISPATCH) && SBOX != 3
+/**
+ * `find_slot` with popcnt
+ */
+STARGET("popcnt") static unsigned find_slot_popcnt (
+  const struct sstate *st,
+  sud_mask *slot
+) {
+  return find_slot(st, slot);
+}
+#endif
+
+/**
+ * kernels of the solver, built for several instruction sets.
+ * the variants are chosen once per process from cpuid (see
+ * `kern_best`) or by `sud_isa_select`
+ */
+struct skern {
+  /* `propagate` */
+  bool (*propagate)(struct sstate *st);
+  /* `find_slot` */
+  unsigned (*slot)(const struct sstate *st, sud_mask *can);
+  /* converts SCELLS characters, false if one is invalid */
+  bool (*classify)(sud_cell grid[], const char buf[]);
+  /* checks the numbers of a grid, false if a number is
+    invalid or given twice in a unit */
+  bool (*check)(const sud_cell grid[]);
+};
+
+/* the kernels of the process and their instruction set */
+static struct skern skern;
+static enum sud_isa skern_isa;
+
+/**
+ * returns a index in the grid with the least possibilities,
+ * ties go to the slot in the fullest unit (the most
+ * constrained row, column or group)
+ *
+ * @param  st   the search state
+ * @param  slot candidate bitmask output
+ * @return      the index or NOINDEX if no index was found
+ */
+static unsigned find_slot_unit (
+  const struct sstate *st,
+  sud_mask *slot
+) {
+  assert(st != 0);
+  assert(slot != 0);
+  unsigned idx = NOINDEX;
+  unsigned prv = SSIZE + 1;
+  unsigned deg = 0;
+  sud_mask res = 0;
+  for (unsigned i = 0; i < SCELLS; ++i) {
+    if (st->grid[i] != 0) {
+      continue;
+    }
+    unsigned len = 0;
+    const sud_mask msk = find_cans(st, i, &len);
+    if (len > prv) {
+      continue;
+    }
+    /* numbers placed in the fullest unit of the slot */
+    unsigned cnt = __builtin_popcount(st->rows[IDX_ROW(i)]);
+    const unsigned col = __builtin_popcount(st->cols[IDX_COL(i)]);
+    const unsigned grp = __builtin_popcount(st->grps[IDX_GRP(i)]);
+    cnt = col > cnt ? col : cnt;
+    cnt = grp > cnt ? grp : cnt;
+    if (len < prv || cnt > deg) {
+      /* better candidate */
+      prv = len;
+      deg = cnt;
+      res = msk;
+      idx = i;
+      if (len == 0) {
+        /* dead end */
+        break;
+      }
+    }
+  }
+  *slot = res;
+  return idx;
+}
+
+/**
+ * returns the lowest candidate of a slot
+ *
+ * @param  st  the search state
+ * @param  idx the index in the grid
+ * @param  can the candidates still to be tried
+ * @return     the number
+ */
+static unsigned next_number (
+  const struct sstate *st,
+  unsigned idx,
+  sud_mask can
+) {
+  (void) st;
+  (void) idx;
+  assert(can != 0);
+  return __builtin_ctz(can);
+}
+
+/**
+ * returns the least constraining candidate of a slot, the one
+ * that is a candidate in the fewest empty peers of the slot
+ * (ties go to the lowest number)
+ *
+ * @param  st  the search state
+ * @param  idx the index in the grid
+ * @param  can the candidates still to be tried
+ * @return     the number
+ */
+static unsigned next_number_lcv (
+  const struct sstate *st,
+  unsigned idx,
+  sud_mask can
+) {
+  assert(st != 0);
+  assert(can != 0);
+  if ((can & (can - 1)) == 0) {
+    /* nothing to choose */
+    return __builtin_ctz(can);
+  }
+  const unsigned row = IDX_ROW(idx);
+  const unsigned col = IDX_COL(idx);
+  /* how often each number is a candidate of a peer */
+  unsigned hits[SSIZE + 1] = {0};
+  for (unsigned unt = 0; unt < 3; ++unt) {
+    const unsigned num = unt == 0 ? row : unt == 1 ? col : IDX_GRP(idx);
+    for (unsigned pos = 0; pos < SSIZE; ++pos) {
+      const unsigned oth = unit_slot(unt * SSIZE + num, pos);
+      if (oth == idx || st->grid[oth] != 0) {
+        continue;
+      }
+      if (unt == 2 && (IDX_ROW(oth) == row || IDX_COL(oth) == col)) {
+        /* already seen in the row or column */
+        continue;
+      }
+      sud_mask msk = find_cans(st, oth, 0) & can;
+      while (msk) {
+        hits[__builtin_ctz(msk)] += 1;
+        msk &= msk - 1;
+      }
+    }
+  }
+  unsigned res = 0;
+  for (sud_mask msk = can; msk; msk &= msk - 1) {
+    const unsigned num = __builtin_ctz(msk);
+    if (res == 0 || hits[num] < hits[res]) {
+      res = num;
+    }
+  }
+  return res;
+}
+
+/**
+ * branching heuristic of the bitmask engine, the slot to
+ * branch on and the order its candidates are tried in
+ */
+struct sheur {
+  /* returns the slot and its candidates, NOINDEX if the grid is full */
+  unsigned (*slot)(const struct sstate *st, sud_mask *can);
+  /* returns the next candidate of the slot to be tried */
+  unsigned (*next)(const struct sstate *st, unsigned idx, sud_mask can);
+};
+
+/* the heuristics, in the order of `enum sud_heur`, a slot
+  of 0 is the slot kernel (see `skern`) */
+static const struct sheur sheurs[] = {
+  { 0, next_number },
+  { find_slot_unit, next_number },
+  { 0, next_number_lcv }
+};
+
+/**
+ * counts a solution of the current solve. only the solution
+ * that reaches the limit is kept, all others are just counted
+ *
+ * @return true if the limit is reached
+ */
+static inline bool count_solution (
+  struct spool *pl
+) {
+  return atomic_fetch_add(&pl->count, 1) + 1 >= pl->limit;
+}
+
+/**
+ * starts the budgets of a solve
+ *
+ * @param pl   the pool (budgets and status)
+ * @param conf the configuration with the budgets
+ */
+static void budget_start (
+  struct spool *pl,
+  const struct sud_conf *conf
+) {
+  assert(pl != 0);
+  assert(conf != 0);
+  atomic_store(&pl->stop, false);
+  atomic_store(&pl->spent, false);
+  atomic_store(&pl->used, 0);
+  pl->budget = conf->budget;
+  pl->deadline = conf->timeout
+    ? mono_clock() + (uint64_t) conf->timeout * 1000
+    : 0;
+  /* the calling thread searches from here on */
+  scheck = snodes;
+}
+
+/**
+ * checks the budgets of the current solve, called by every
+ * searching thread once it visited SBUDGET nodes since its
+ * last check (or the start of its search). the nodes are
+ * charged to the solve, so a single-threaded solve gives up
+ * at the same node whatever was solved before. once a budget
+ * ran out, all searches of the solve give up
+ *
+ * @param  pl the pool (budgets and status)
+ * @return    true if the search has to give up
+ */
+static bool budget_check (
+  struct spool *pl
+) {
+  assert(pl != 0);
+  bool out = false;
+  if (pl->budget) {
+    /* the nodes since the last check */
+    const unsigned long used = snodes - scheck;
+    out = atomic_fetch_add(&pl->used, used) + used >= pl->budget;
+  }
+  scheck = snodes;
+  if (pl->deadline && !out) {
+    out = mono_clock() >= pl->deadline;
+  }
+  if (out) {
+    atomic_store(&pl->spent, true);
+    atomic_store(&pl->stop, true);
+  }
+  return out;
+}
+
+/**
+ * enumerates the solutions, same search as `find_solution_st`.
+ * each solution is passed to the callback in search order, the
+ * search only continues once the callback returned (backpressure)
+ *
+ * @param  st  the search state
+ * @param  en  the enumeration
+ * @param  dep current branch depth
+ * @return     true if the callback requested a stop
+ */
+static bool enum_solutions_st (
+  struct sstate *st,
+  struct sud_enum *en,
+  unsigned dep
+) {
+  assert(st != 0);
+  assert(en != 0);
+  assert(dep <= SCELLS);
+  unsigned idx;
+
+  snodes += 1;
+  STATS_NODE();
+
+  /* everything after this is undone on failure */
+  const unsigned tlen = st->tlen;
+  const unsigned elen = st->elen;
+
+  if (!skern.propagate(st)) {
+    /* contradiction */
+    undo_trail(st, tlen, elen);
+    return false;
+  }
+
+  /* candidates */
+  sud_mask can = 0;
+  STATS_CLOCK(beg);
+  idx = skern.slot(st, &can);
+  STATS_SLOT(beg);
+
+  if (idx == NOINDEX) {
+    /* no empty slot found */
+    const bool seen = en->skip && dep == en->replay;
+    en->skip = false;
+    en->len = dep;
+    if (!seen) {
+      en->count += 1;
+      if (!en->emit(st->grid, en->arg)) {
+        return true;
+      }
+    }
+    undo_trail(st, tlen, elen);
+    return false;
+  }
+
+  STATS_BRANCH(__builtin_popcount(can));
+
+  /* state after propagation */
+  const unsigned plen = st->tlen;
+  const unsigned pelen = st->elen;
+
+  for (unsigned num = 1; num <= SSIZE; ++num) {
+    if (!(can & ((sud_mask) 1 << num))) {
+      continue;
+    }
+    if (dep < en->replay) {
+      if (num < en->path[dep]) {
+        /* before the cursor */
+        continue;
+      }
+      if (num > en->path[dep]) {
+        /* past the cursor, everything below is new */
+        en->replay = dep;
+        en->skip = false;
+      }
+    }
+    en->path[dep] = num;
+    push_number(st, idx, num);
+    STATS_DOWN();
+    if (enum_solutions_st(st, en, dep + 1)) {
+      return true;
+    }
+    STATS_UP();
+    undo_trail(st, plen, pelen);
+  }
+
+  /* no more solutions */
+  undo_trail(st, tlen, elen);
+  return false;
+}
+
+/**
+ * returns the next number of a splitmix64 generator
+ *
+ * @param  rng the generator state
+ * @return     the random number
+ */
+static inline uint64_t rng_next (
+  uint64_t *rng
+) {
+  assert(rng != 0);
+  uint64_t res = (*rng += 0x9E3779B97F4A7C15);
+  res = (res ^ (res >> 30)) * 0xBF58476D1CE4E5B9;
+  res = (res ^ (res >> 27)) * 0x94D049BB133111EB;
+  return res ^ (res >> 31);
+}
+
+/**
+ * fills the grid with a random solution, same search as
+ * `find_solution_st` but the candidates are tried in random order
+ *
+ * @param  st  the search state
+ * @param  rng the generator state
+ * @return     true if the grid was filled, false otherwise
+ */
+static bool fill_grid_st (
+  struct sstate *st,
+  uint64_t *rng
+) {
+  assert(st != 0);
+  assert(rng != 0);
+  unsigned idx;
+
+  snodes += 1;
+  STATS_NODE();
+
+  /* everything after this is undone on failure */
+  const unsigned tlen = st->tlen;
+  const unsigned elen = st->elen;
+
+  if (!skern.propagate(st)) {
+    /* contradiction */
+    undo_trail(st, tlen, elen);
+    return false;
+  }
+
+  /* candidates */
+  sud_mask can = 0;
+  STATS_CLOCK(beg);
+  idx = skern.slot(st, &can);
+  STATS_SLOT(beg);
+
+  if (idx == NOINDEX) {
+    /* no empty slot found */
+    return true;
+  }
+
+  STATS_BRANCH(__builtin_popcount(can));
+
+  /* candidates in random order */
+  unsigned nums[SSIZE];
+  unsigned len = 0;
+  for (unsigned num = 1; num <= SSIZE; ++num) {
+    if (can & ((sud_mask) 1 << num)) {
+      nums[len++] = num;
+    }
+  }
+  for (unsigned i = len; i > 1; --i) {
+    const unsigned j = rng_next(rng) % i;
+    const unsigned tmp = nums[i - 1];
+    nums[i - 1] = nums[j];
+    nums[j] = tmp;
+  }
+
+  /* state after propagation */
+  const unsigned plen = st->tlen;
+  const unsigned pelen = st->elen;
+
+  for (unsigned i = 0; i < len; ++i) {
+    push_number(st, idx, nums[i]);
+    STATS_DOWN();
+    if (fill_grid_st(st, rng)) {
+      return true;
+    }
+    STATS_UP();
+    undo_trail(st, plen, pelen);
+  }
+
+  /* no solution found */
+  undo_trail(st, tlen, elen);
+  return false;
+}
+
+/**
+ * copies the grid and the masks of a search state into a task
+ *
+ * @param task the task (output)
+ * @param st   the search state
+ */
+static inline void task_store (
+  struct stask *task,
+  const struct sstate *st
+) {
+  assert(task != 0);
+  assert(st != 0);
+  memcpy(task->grid, st->grid, sizeof(task->grid));
+  memcpy(task->rows, st->rows, sizeof(task->rows));
+  memcpy(task->cols, st->cols, sizeof(task->cols));
+  memcpy(task->grps, st->grps, sizeof(task->grps));
+}
+
+/**
+ * builds a search state from a task
+ *
+ * @param st   the search state (output)
+ * @param task the task
+ */
+static inline void task_load (
+  struct sstate *st,
+  const struct stask *task
+) {
+  assert(st != 0);
+  assert(task != 0);
+  memcpy(st->grid, task->grid, sizeof(st->grid));
+  memcpy(st->rows, task->rows, sizeof(st->rows));
+  memcpy(st->cols, task->cols, sizeof(st->cols));
+  memcpy(st->grps, task->grps, sizeof(st->grps));
+  memset(st->excl, 0, sizeof(st->excl));
+  st->tlen = 0;
+  st->elen = 0;
+}
+
+/**
+ * pushes a task onto the bottom of the deque
+ *
+ * @param  dq   the deque
+ * @param  task the task to be copied
+ * @return      false if the deque is full
+ */
+static bool deque_push (
+  struct sdeque *dq,
+  const struct stask *task
+) {
+  assert(dq != 0);
+  assert(task != 0);
+  bool res = false;
+  pthread_mutex_lock(&dq->mtx);
+  if (dq->len < SDEQUE) {
+    memcpy(&dq->task[(dq->top + dq->len) % SDEQUE], task, sizeof(*task));
+    dq->len += 1;
+    res = true;
+  }
+  pthread_mutex_unlock(&dq->mtx);
+  return res;
+}
+
+/**
+ * takes a task from the deque, the owner takes the
+ * newest task (bottom), thieves the oldest one (top)
+ *
+ * @param  dq    the deque
+ * @param  task  task output
+ * @param  steal true to take from the top
+ * @return       false if the deque is empty
+ */
+static bool deque_take (
+  struct sdeque *dq,
+  struct stask *task,
+  bool steal
+) {
+  assert(dq != 0);
+  assert(task != 0);
+  bool res = false;
+  pthread_mutex_lock(&dq->mtx);
+  if (dq->len > 0) {
+    unsigned pos;
+    if (steal) {
+      /* oldest task, usually the biggest subtree */
+      pos = dq->top;
+      dq->top = (dq->top + 1) % SDEQUE;
+    } else {
+      /* newest task */
+      pos = (dq->top + dq->len - 1) % SDEQUE;
+    }
+    memcpy(task, &dq->task[pos], sizeof(*task));
+    dq->len -= 1;
+    res = true;
+  }
+  pthread_mutex_unlock(&dq->mtx);
+  return res;
+}
+
+/**
+ * queues a task for the current solve
+ *
+ * @param  pl   the pool
+ * @param  pi   the worker whose deque is used
+ * @param  task the task to be copied
+ * @return      false if the deque is full
+ */
+static bool pool_push (
+  struct spool *pl,
+  unsigned pi,
+  const struct stask *task
+) {
+  assert(pi < pl->size);
+  /* account the task before it becomes visible */
+  atomic_fetch_add(&pl->pending, 1);
+  if (!deque_push(&pl->deqs[pi], task)) {
+    atomic_fetch_sub(&pl->pending, 1);
+    return false;
+  }
+  atomic_fetch_add(&pl->queued, 1);
+  /* a worker going to sleep increments `idle` before
+    checking `queued`, so one of us sees the other */
+  if (atomic_load(&pl->idle) > 0) {
+    pthread_mutex_lock(&pl->mtx);
+    pthread_cond_signal(&pl->work);
+    pthread_mutex_unlock(&pl->mtx);
+  }
+  return true;
+}
+
+/**
+ * takes a task from the own deque or steals one
+ * from another worker
+ *
+ * @param  pl   the pool
+ * @param  pi   the worker
+ * @param  task task output
+ * @return      false if no task was found
+ */
+static bool pool_take (
+  struct spool *pl,
+  unsigned pi,
+  struct stask *task
+) {
+  assert(pi < pl->size);
+  for (unsigned i = 0; i < pl->size; ++i) {
+    unsigned vi = (pi + i) % pl->size;
+    if (deque_take(&pl->deqs[vi], task, vi != pi)) {
+      atomic_fetch_sub(&pl->queued, 1);
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * stores the solution that reached the limit
+ *
+ * @param pl the pool
+ * @param st the solved search state
+ */
+static void pool_result (
+  struct spool *pl,
+  const struct sstate *st
+) {
+  assert(st != 0);
+  pthread_mutex_lock(&pl->mtx);
+  if (!atomic_load(&pl->found)) {
+    task_store(&pl->result, st);
+    atomic_store(&pl->found, true);
+    /* let the other workers give up */
+    atomic_store(&pl->stop, true);
+  }
+  pthread_mutex_unlock(&pl->mtx);
+}
+
+/**
+ * hands the untried candidates of the shallowest branch with
+ * candidates left (the biggest subtrees) to idle workers, one
+ * task per candidate. candidates that do not fit into the deque
+ * stay with the branch
+ *
+ * @param pl  the pool
+ * @param pi  the worker
+ * @param st  the search state
+ * @param dep number of branches in `st->frames`
+ */
+static void pool_split (
+  struct spool *pl,
+  unsigned pi,
+  struct sstate *st,
+  unsigned dep
+) {
+  assert(st != 0);
+  unsigned fi = 0;
+  while (fi < dep && st->frames[fi].cans == 0) {
+    fi += 1;
+  }
+  if (fi == dep) {
+    /* nothing left to hand out */
+    return;
+  }
+  struct sframe *fr = &st->frames[fi];
+
+  /* the state of the branch, without the numbers placed below it */
+  struct stask base;
+  task_store(&base, st);
+  for (unsigned pos = fr->tlen; pos < st->tlen; ++pos) {
+    const unsigned idx = st->trail[pos];
+    const sud_mask bit = ~((sud_mask) 1 << base.grid[idx]);
+    base.grid[idx] = 0;
+    base.rows[IDX_ROW(idx)] &= bit;
+    base.cols[IDX_COL(idx)] &= bit;
+    base.grps[IDX_GRP(idx)] &= bit;
+  }
+
+  while (fr->cans) {
+    const unsigned num = __builtin_ctz(fr->cans);
+    const sud_mask bit = (sud_mask) 1 << num;
+    struct stask sub;
+    memcpy(&sub, &base, sizeof(sub));
+    sub.grid[fr->idx] = num;
+    sub.rows[IDX_ROW(fr->idx)] |= bit;
+    sub.cols[IDX_COL(fr->idx)] |= bit;
+    sub.grps[IDX_GRP(fr->idx)] |= bit;
+    if (!pool_push(pl, pi, &sub)) {
+      /* deque is full */
+      break;
+    }
+    fr->cans &= ~bit;
+  }
+}
+
+/**
+ * tries to find a solution for the given puzzle.
+ * propagates singles and locked candidates on every node,
+ * then a simple/stupid xxx (badword on github!)
+ *
+ * the search continues until `pl->limit` solutions were
+ * counted, the state then holds the last one. the slot of a
+ * branch and the order of its candidates come from the
+ * heuristic of the pool (see `sheurs`)
+ *
+ * iterative, the branches live in `st->frames` instead of the
+ * call stack. on a worker the untried candidates of the search
+ * are handed to idle workers (see `pool_split`)
+ *
+ * gives up as soon as the pool requests a stop or a budget
+ * runs out (the result is meaningless then)
+ *
+ * @param  pl the pool (status and limit)
+ * @param  pi the worker, no splitting if not below `pl->size`
+ * @param  st the search state
+ * @return    true if the limit was reached, false otherwise
+ */
+static bool find_solution_st (
+  struct spool *pl,
+  unsigned pi,
+  struct sstate *st
+) {
+  assert(pl != 0);
+  assert(st != 0);
+  /* everything after this is undone on failure */
+  const unsigned tlen = st->tlen;
+  const unsigned elen = st->elen;
+  const bool split = pi < pl->size;
+  const struct sheur *hr = &sheurs[pl->heur];
+  unsigned (*const slot)(const struct sstate *, sud_mask *) =
+    hr->slot ? hr->slot : skern.slot;
+  struct sframe *fr = 0;
+  unsigned dep = 0;
+
+  for (;;) {
+    /* cooperative cancellation, checked once per node */
+    if (atomic_load_explicit(&pl->stop, memory_order_relaxed)) {
+      /* another worker is done */
+      undo_trail(st, tlen, elen);
+      return false;
+    }
+
+    if (split &&
+        atomic_load_explicit(&pl->idle, memory_order_relaxed) > 0 &&
+        atomic_load_explicit(&pl->queued, memory_order_relaxed) == 0) {
+      /* somebody is waiting for work */
+      pool_split(pl, pi, st, dep);
+    }
+
+    snodes += 1;
+    STATS_NODE();
+
+    if (snodes - scheck >= SBUDGET && budget_check(pl)) {
+      /* out of budget */
+      undo_trail(st, tlen, elen);
+      return false;
+    }
+
+    bool dead = !skern.propagate(st);
+    if (!dead) {
+      /* candidates */
+      sud_mask can = 0;
+      STATS_CLOCK(beg);
+      const unsigned idx = slot(st, &can);
+      STATS_SLOT(beg);
+
+      if (idx == NOINDEX) {
+        /* no empty slot found */
+        if (count_solution(pl)) {
+          return true;
+        }
+        /* keep counting */
+        dead = true;
+      } else {
+        STATS_BRANCH(__builtin_popcount(can));
+        /* new branch, with the state after propagation */
+        assert(dep < SCELLS);
+        fr = &st->frames[dep++];
+        fr->idx = idx;
+        fr->cans = can;
+        fr->tlen = st->tlen;
+        fr->elen = st->elen;
+      }
+    }
+
+    if (dead) {
+      /* back to the last branch with candidates left */
+      for (;;) {
+        if (dep == 0) {
+          /* no solution found */
+          undo_trail(st, tlen, elen);
+          return false;
+        }
+        fr = &st->frames[dep - 1];
+        STATS_UP();
+        undo_trail(st, fr->tlen, fr->elen);
+        if (fr->cans) {
+          break;
+        }
+        dep -= 1;
+      }
+    }
+
+    /* next candidate of the branch */
+    assert(fr->cans != 0);
+    const unsigned num = hr->next(st, fr->idx, fr->cans);
+    fr->cans &= ~((sud_mask) 1 << num);
+    push_number(st, fr->idx, num);
+    STATS_DOWN();
+  }
+}
+
+/**
+ * runs a task, the search splits off work by itself
+ * whenever other workers are idle
+ *
+ * @param pl the pool
+ * @param pi the worker
+ * @param st the task
+ */
+static void pool_run (
+  struct spool *pl,
+  unsigned pi,
+  struct sstate *st
+) {
+  assert(st != 0);
+  if (atomic_load(&pl->stop)) {
+    /* solution already known */
+    return;
+  }
+
+  /* depth is counted from the task */
+  STATS_ROOT();
+
+  if (find_solution_st(pl, pi, st)) {
+    pool_result(pl, st);
+  }
+}
+
+/**
+ * callback for pthread, runs tasks until the pool is stopped
+ *
+ * @param pass the deque of the worker
+ */
+static void * pool_worker (void *pass)
+{
+  struct sdeque *own = pass;
+  struct spool *pl = own->pool;
+  const unsigned pi = own - pl->deqs;
+  #if defined(SSTATS)
+    sstats = &pl->stats[pi];
+  #endif
+  struct stask task;
+  struct sstate st;
+
+  /* pinned first, so the deque and the stack are
+    allocated on the numa node of the worker */
+  if (pl->cpus) {
+    sud_pin(pl->cpus[pi]);
+  }
+  own->task = aligned_alloc(SLINE, SDEQUE * sizeof(struct stask));
+  pthread_mutex_lock(&pl->mtx);
+  pl->nomem |= !own->task;
+  pl->ready += 1;
+  pthread_cond_signal(&pl->done);
+  pthread_mutex_unlock(&pl->mtx);
+
+  for (;;) {
+    if (!pool_take(pl, pi, &task)) {
+      /* nothing to do, wait for work */
+      bool quit;
+      pthread_mutex_lock(&pl->mtx);
+      atomic_fetch_add(&pl->idle, 1);
+      while (!pl->quit && atomic_load(&pl->queued) == 0) {
+        pthread_cond_wait(&pl->work, &pl->mtx);
+      }
+      atomic_fetch_sub(&pl->idle, 1);
+      quit = pl->quit;
+      pthread_mutex_unlock(&pl->mtx);
+      if (quit) {
+        break;
+      }
+      continue;
+    }
+
+    const unsigned long base = snodes;
+    scheck = snodes;
+    task_load(&st, &task);
+    pool_run(pl, pi, &st);
+    atomic_fetch_add(&pl->nodes, snodes - base);
+    if (pl->budget) {
+      /* the nodes after the last check of the task */
+      atomic_fetch_add(&pl->used, snodes - scheck);
+    }
+
+    if (atomic_fetch_sub(&pl->pending, 1) == 1) {
+      /* last task of the current solve */
+      pthread_mutex_lock(&pl->mtx);
+      pthread_cond_signal(&pl->done);
+      pthread_mutex_unlock(&pl->mtx);
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * stops the workers and frees the pool, also cleans
+ * up a pool that could not be started completely
+ *
+ * @param pl the pool
+ */
+static void stop_pool (
+  struct spool *pl
+) {
+  assert(pl != 0);
+  if (pl->size == 0) {
+    /* no pool */
+    return;
+  }
+
+  pthread_mutex_lock(&pl->mtx);
+  pl->quit = true;
+  pthread_cond_broadcast(&pl->work);
+  pthread_mutex_unlock(&pl->mtx);
+
+  /* workers steal from each other until they quit,
+    so no deque can go away before all of them joined */
+  for (unsigned pi = 0; pi < pl->running; ++pi) {
+    pthread_join(pl->thrd[pi], 0);
+  }
+
+  for (unsigned pi = 0; pi < pl->size; ++pi) {
+    pthread_mutex_destroy(&pl->deqs[pi].mtx);
+    free(pl->deqs[pi].task);
+  }
+
+  pthread_cond_destroy(&pl->done);
+  pthread_cond_destroy(&pl->work);
+  pthread_mutex_destroy(&pl->mtx);
+  #if defined(SSTATS)
+    free(pl->stats);
+  #endif
+  free(pl->cpus);
+  free(pl->deqs);
+  free(pl->thrd);
+  pl->cpus = 0;
+  pl->size = 0;
+  pl->running = 0;
+  pl->ready = 0;
+  pl->nomem = false;
+}
+
+/**
+ * creates the worker pool, called once per context. each
+ * worker pins itself and allocates its own deque, the pool
+ * is ready once all of them did
+ *
+ * @param  pl    the pool
+ * @param  size  number of workers, 0 for one per cpu
+ * @param  place placement of the workers
+ * @return       SUD_OK, SUD_EINVAL, SUD_ENOMEM or SUD_ETHREAD
+ */
+static int start_pool (
+  struct spool *pl,
+  unsigned size,
+  const struct sud_place *place
+) {
+  assert(pl != 0);
+  assert(pl->size == 0);
+  assert(place != 0);
+  if (size == 0) {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    size = ncpu > 0 ? ncpu : 1;
+  }
+
+  pl->thrd = calloc(size, sizeof(pthread_t));
+  pl->deqs = calloc(size, sizeof(struct sdeque));
+  bool mem = pl->thrd && pl->deqs;
+  if (place->bind != SUD_BIND_NONE) {
+    pl->cpus = calloc(size, sizeof(unsigned));
+    mem = mem && pl->cpus;
+  }
+  #if defined(SSTATS)
+    pl->stats = calloc(size, sizeof(struct sstats));
+    mem = mem && pl->stats;
+  #endif
+  int err = mem ? SUD_OK : SUD_ENOMEM;
+  if (err == SUD_OK && pl->cpus) {
+    err = sud_place_cpus(place, size, pl->cpus, 0);
+  }
+  if (err != SUD_OK) {
+    #if defined(SSTATS)
+      free(pl->stats);
+    #endif
+    free(pl->cpus);
+    free(pl->deqs);
+    free(pl->thrd);
+    pl->cpus = 0;
+    return err;
+  }
+
+  pthread_mutex_init(&pl->mtx, 0);
+  pthread_cond_init(&pl->work, 0);
+  pthread_cond_init(&pl->done, 0);
+
+  for (unsigned pi = 0; pi < size; ++pi) {
+    struct sdeque *dq = &pl->deqs[pi];
+    pthread_mutex_init(&dq->mtx, 0);
+    dq->pool = pl;
+  }
+
+  /* workers may steal as soon as they run */
+  pl->size = size;
+
+  for (unsigned pi = 0; pi < size; ++pi) {
+    if (pthread_create(&pl->thrd[pi], 0, pool_worker, &pl->deqs[pi])) {
+      /* joins the workers started so far */
+      stop_pool(pl);
+      return SUD_ETHREAD;
+    }
+    pl->running += 1;
+  }
+
+  /* until every worker has its deque */
+  pthread_mutex_lock(&pl->mtx);
+  while (pl->ready < pl->running) {
+    pthread_cond_wait(&pl->done, &pl->mtx);
+  }
+  const bool nomem = pl->nomem;
+  pthread_mutex_unlock(&pl->mtx);
+  if (nomem) {
+    stop_pool(pl);
+    return SUD_ENOMEM;
+  }
+  return SUD_OK;
+}
+
+/**
+ * solves the puzzle on the worker pool. all workers count
+ * into `pl->count` and stop as soon as the limit is reached
+ *
+ * @see find_solution_st
+ *
+ * @param  pl the pool
+ * @param  st the search state
+ * @return    true if the limit was reached, false otherwise
+ */
+static bool find_solution_mt (
+  struct spool *pl,
+  struct sstate *st
+) {
+  assert(pl != 0);
+  assert(st != 0);
+  assert(pl->size > 0);
+
+  atomic_store(&pl->found, false);
+  atomic_store(&pl->stop, false);
+  atomic_store(&pl->nodes, 0);
+
+  /* idle workers will split and steal from here */
+  struct stask root;
+  task_store(&root, st);
+  pool_push(pl, 0, &root);
+
+  /* wait for all tasks to come back, once the limit is
+    reached the remaining searches stop within one node */
+  pthread_mutex_lock(&pl->mtx);
+  while (atomic_load(&pl->pending) > 0) {
+    pthread_cond_wait(&pl->done, &pl->mtx);
+  }
+  pthread_mutex_unlock(&pl->mtx);
+
+  /* account the nodes of all workers */
+  snodes += atomic_load(&pl->nodes);
+
+  if (!atomic_load(&pl->found)) {
+    return false;
+  }
+
+  /* copy solution */
+  task_load(st, &pl->result);
+  return true;
+}
+
+/**
+ * covers a column of the exact cover matrix
+ *
+ * @param dx  the matrix
+ * @param col the column header
+ */
+static void dlx_cover (
+  struct sdlx *dx,
+  unsigned col
+) {
+  assert(dx != 0);
+  dx->r[dx->l[col]] = dx->r[col];
+  dx->l[dx->r[col]] = dx->l[col];
+  for (unsigned i = dx->d[col]; i != col; i = dx->d[i]) {
+    for (unsigned j = dx->r[i]; j != i; j = dx->r[j]) {
+      dx->d[dx->u[j]] = dx->d[j];
+      dx->u[dx->d[j]] = dx->u[j];
+      dx->size[dx->c[j]] -= 1;
+    }
+  }
+}
+
+/**
+ * reverts `dlx_cover`, must be called in reverse order
+ *
+ * @param dx  the matrix
+ * @param col the column header
+ */
+static void dlx_uncover (
+  struct sdlx *dx,
+  unsigned col
+) {
+  assert(dx != 0);
+  for (unsigned i = dx->u[col]; i != col; i = dx->u[i]) {
+    for (unsigned j = dx->l[i]; j != i; j = dx->l[j]) {
+      dx->size[dx->c[j]] += 1;
+      dx->d[dx->u[j]] = j;
+      dx->u[dx->d[j]] = j;
+    }
+  }
+  dx->r[dx->l[col]] = col;
+  dx->l[dx->r[col]] = col;
+}
+
+/**
+ * builds the exact cover matrix: one row for each
+ * number in each slot, one column for each constraint
+ * (slot filled, number in row, column and group)
+ *
+ * @param dx the matrix
+ */
+static void dlx_build (
+  struct sdlx *dx
+) {
+  assert(dx != 0);
+  /* root and column headers form the header row */
+  for (unsigned col = 0; col <= DLX_COLS; ++col) {
+    dx->l[col] = col == 0 ? DLX_COLS : col - 1;
+    dx->r[col] = col == DLX_COLS ? 0 : col + 1;
+    dx->u[col] = col;
+    dx->d[col] = col;
+    dx->c[col] = col;
+    dx->size[col] = 0;
+  }
+
+  unsigned node = DLX_COLS + 1;
+  for (unsigned row = 0; row < DLX_ROWS; ++row) {
+    const unsigned idx = row / SSIZE;
+    const unsigned off = row % SSIZE;
+    const unsigned cols[4] = {
+      1 + idx,
+      1 + SCELLS + IDX_ROW(idx) * SSIZE + off,
+      1 + SCELLS * 2 + IDX_COL(idx) * SSIZE + off,
+      1 + SCELLS * 3 + IDX_GRP(idx) * SSIZE + off
+    };
+    dx->rown[row] = node;
+    for (unsigned i = 0; i < 4; ++i, ++node) {
+      const unsigned col = cols[i];
+      /* append to the bottom of the column */
+      dx->u[node] = dx->u[col];
+      dx->d[node] = col;
+      dx->d[dx->u[col]] = node;
+      dx->u[col] = node;
+      dx->c[node] = col;
+      dx->row[node] = row;
+      dx->size[col] += 1;
+      /* circular list of the row */
+      dx->l[node] = i == 0 ? node + 3 : node - 1;
+      dx->r[node] = i == 3 ? node - 3 : node + 1;
+    }
+  }
+}
+
+/**
+ * algorithm x, picks the column with the least rows
+ *
+ * @param  dx  the matrix
+ * @param  pl  the pool (budgets)
+ * @param  dep the search depth
+ * @return     true if a solution was found, false otherwise
+ */
+static bool dlx_search (
+  struct sdlx *dx,
+  struct spool *pl,
+  unsigned dep
+) {
+  assert(dx != 0);
+  if (atomic_load_explicit(&pl->stop, memory_order_relaxed)) {
+    /* out of budget */
+    return false;
+  }
+  snodes += 1;
+  STATS_NODE();
+  if (snodes - scheck >= SBUDGET && budget_check(pl)) {
+    return false;
+  }
+  if (dx->r[0] == 0) {
+    /* all constraints satisfied */
+    dx->nsol = dep;
+    return true;
+  }
+
+  unsigned col = dx->r[0];
+  for (unsigned i = dx->r[col]; i != 0; i = dx->r[i]) {
+    if (dx->size[i] < dx->size[col]) {
+      col = i;
+    }
+  }
+
+  if (dx->size[col] == 0) {
+    /* no candidates */
+    return false;
+  }
+
+  STATS_BRANCH(dx->size[col]);
+
+  dlx_cover(dx, col);
+  for (unsigned i = dx->d[col]; i != col; i = dx->d[i]) {
+    dx->sol[dep] = dx->row[i];
+    for (unsigned j = dx->r[i]; j != i; j = dx->r[j]) {
+      dlx_cover(dx, dx->c[j]);
+    }
+    STATS_DOWN();
+    if (dlx_search(dx, pl, dep + 1)) {
+      return true;
+    }
+    STATS_UP();
+    for (unsigned j = dx->l[i]; j != i; j = dx->l[j]) {
+      dlx_uncover(dx, dx->c[j]);
+    }
+  }
+  dlx_uncover(dx, col);
+
+  /* no solution found */
+  return false;
+}
+
+/**
+ * solves the puzzle with dancing links, single threaded
+ *
+ * @param  dx   the matrix
+ * @param  pl   the pool (budgets)
+ * @param  grid the sudoku grid
+ * @return      true if a solution was found, false otherwise
+ */
+static bool find_solution_dlx (
+  struct sdlx *dx,
+  struct spool *pl,
+  sud_cell grid[]
+) {
+  assert(dx != 0);
+  assert(grid != 0);
+  /* no per-node allocation, all nodes live in the context */
+  dlx_build(dx);
+
+  /* select the rows of the given numbers */
+  for (unsigned idx = 0; idx < SCELLS; ++idx) {
+    if (grid[idx]) {
+      unsigned node = dx->rown[idx * SSIZE + grid[idx] - 1];
+      dlx_cover(dx, dx->c[node]);
+      for (unsigned j = dx->r[node]; j != node; j = dx->r[j]) {
+        dlx_cover(dx, dx->c[j]);
+      }
+    }
+  }
+
+  if (!dlx_search(dx, pl, 0)) {
+    return false;
+  }
+
+  for (unsigned i = 0; i < dx->nsol; ++i) {
+    grid[dx->sol[i] / SSIZE] = dx->sol[i] % SSIZE + 1;
+  }
+  return true;
+}
+
+#if SBOX == 3
+/* all slots of a band */
+#define BITS_BAND 0x7FFFFFF
+/* first row, column and group of a band */
+#define BITS_ROW 0x1FF
+#define BITS_COL 0x40201
+#define BITS_GRP 0x1C0E07
+
+/* peers (row, column and group without the slot) per slot */
+static uint32_t bits_peers[SCELLS][3];
+
+/* `bits_peers` is built once */
+static pthread_once_t bits_once = PTHREAD_ONCE_INIT;
+
+/**
+ * builds the peer boards, called once
+ *
+ */
+static void bits_setup ()
+{
+  for (unsigned idx = 0; idx < SCELLS; ++idx) {
+    for (unsigned oth = 0; oth < SCELLS; ++oth) {
+      if (oth != idx && (
+          IDX_ROW(oth) == IDX_ROW(idx) ||
+          IDX_COL(oth) == IDX_COL(idx) ||
+          IDX_GRP(oth) == IDX_GRP(idx))) {
+        bits_peers[idx][oth / 27] |= 1u << (oth % 27);
+      }
+    }
+  }
+}
+
+/**
+ * places a digit, the slot is removed from all boards
+ * and the peers from the board of the digit
+ *
+ * @param bs  the bitboard state
+ * @param idx the index in the grid
+ * @param dig the digit (number - 1)
+ */
+static inline void bits_place (
+  struct sbits *bs,
+  unsigned idx,
+  unsigned dig
+) {
+  assert(bs != 0);
+  assert(dig < 9);
+  const unsigned band = idx / 27;
+  const uint32_t bit = 1u << (idx % 27);
+  for (unsigned d = 0; d < 9; ++d) {
+    bs->cand[d][band] &= ~bit;
+  }
+  bs->cand[dig][0] &= ~bits_peers[idx][0];
+  bs->cand[dig][1] &= ~bits_peers[idx][1];
+  bs->cand[dig][2] &= ~bits_peers[idx][2];
+  bs->done[dig][band] |= bit;
+  bs->open[band] &= ~bit;
+}
+
+/**
+ * places a digit in the only slot of a unit, if there
+ * is exactly one
+ *
+ * @param  bs   the bitboard state
+ * @param  dig  the digit
+ * @param  band the band of the unit
+ * @param  cand candidates of the digit in the unit
+ * @param  chg  set to true if the digit was placed
+ * @return      false if the unit has no slot for the digit
+ */
+static inline bool bits_unit (
+  struct sbits *bs,
+  unsigned dig,
+  unsigned band,
+  uint32_t cand,
+  bool *chg
+) {
+  if (cand == 0) {
+    /* digit has no slot left */
+    return false;
+  }
+  if ((cand & (cand - 1)) == 0) {
+    /* hidden single */
+    bits_place(bs, band * 27 + __builtin_ctz(cand), dig);
+    *chg = true;
+  }
+  return true;
+}
+
+/**
+ * places naked and hidden singles until nothing changes
+ *
+ * @param  bs the bitboard state
+ * @return    false on a contradiction
+ */
+static bool bits_propagate (
+  struct sbits *bs
+) {
+  assert(bs != 0);
+  bool chg;
+  do {
+    chg = false;
+
+    /* naked singles, counted for 27 slots at once */
+    for (unsigned b = 0; b < 3; ++b) {
+      uint32_t once = 0;
+      uint32_t more = 0;
+      for (unsigned d = 0; d < 9; ++d) {
+        more |= once & bs->cand[d][b];
+        once |= bs->cand[d][b];
+      }
+      if (bs->open[b] & ~once) {
+        /* empty slot without candidates */
+        return false;
+      }
+      uint32_t sgl = once & ~more & bs->open[b];
+      while (sgl) {
+        const uint32_t bit = sgl & -sgl;
+        sgl ^= bit;
+        unsigned d = 0;
+        while (d < 9 && !(bs->cand[d][b] & bit)) {
+          d += 1;
+        }
+        if (d == 9) {
+          /* lost its candidate to another single */
+          return false;
+        }
+        bits_place(bs, b * 27 + __builtin_ctz(bit), d);
+        chg = true;
+      }
+    }
+
+    /* hidden singles, per digit and unit */
+    for (unsigned d = 0; d < 9; ++d) {
+      const uint32_t *done = bs->done[d];
+      for (unsigned b = 0; b < 3; ++b) {
+        for (unsigned i = 0; i < 3; ++i) {
+          if (!(done[b] & (BITS_ROW << (i * 9))) &&
+              !bits_unit(bs, d, b,
+                bs->cand[d][b] & (BITS_ROW << (i * 9)), &chg)) {
+            return false;
+          }
+          if (!(done[b] & (BITS_GRP << (i * 3))) &&
+              !bits_unit(bs, d, b,
+                bs->cand[d][b] & (BITS_GRP << (i * 3)), &chg)) {
+            return false;
+          }
+        }
+      }
+      for (unsigned c = 0; c < 9; ++c) {
+        const uint32_t col = BITS_COL << c;
+        if ((done[0] | done[1] | done[2]) & col) {
+          /* digit already placed in this column */
+          continue;
+        }
+        const uint32_t c0 = bs->cand[d][0] & col;
+        const uint32_t c1 = bs->cand[d][1] & col;
+        const uint32_t c2 = bs->cand[d][2] & col;
+        const unsigned cnt = __builtin_popcount(c0) +
+          __builtin_popcount(c1) + __builtin_popcount(c2);
+        if (cnt == 0) {
+          return false;
+        }
+        if (cnt == 1) {
+          const unsigned b = c0 ? 0 : c1 ? 1 : 2;
+          bits_place(bs, b * 27 + __builtin_ctz(c0 | c1 | c2), d);
+          chg = true;
+        }
+      }
+    }
+  } while (chg);
+
+  return true;
+}
+
+/**
+ * recursive bitboard search, branches on a slot with
+ * two candidates if there is one
+ *
+ * @param  pl the pool (budgets)
+ * @param  bs the bitboard state, solved on success
+ * @return    true if a solution was found, false otherwise
+ */
+static bool bits_search (
+  struct spool *pl,
+  struct sbits *bs
+) {
+  assert(bs != 0);
+  if (atomic_load_explicit(&pl->stop, memory_order_relaxed)) {
+    /* out of budget */
+    return false;
+  }
+  snodes += 1;
+  STATS_NODE();
+  if (snodes - scheck >= SBUDGET && budget_check(pl)) {
+    return false;
+  }
+
+  if (!bits_propagate(bs)) {
+    /* contradiction */
+    return false;
+  }
+
+  if (!(bs->open[0] | bs->open[1] | bs->open[2])) {
+    /* all slots filled */
+    return true;
+  }
+
+  /* slot with the least candidates, bivalue slots first */
+  STATS_CLOCK(beg);
+  unsigned idx = NOINDEX;
+  unsigned prv = 10;
+  for (unsigned b = 0; b < 3 && prv > 2; ++b) {
+    uint32_t once = 0;
+    uint32_t twice = 0;
+    uint32_t more = 0;
+    for (unsigned d = 0; d < 9; ++d) {
+      const uint32_t m = bs->cand[d][b];
+      more |= twice & m;
+      twice |= once & m;
+      once |= m;
+    }
+    const uint32_t bival = twice & ~more & bs->open[b];
+    if (bival) {
+      idx = b * 27 + __builtin_ctz(bival);
+      prv = 2;
+      break;
+    }
+    for (uint32_t open = bs->open[b]; open; open &= open - 1) {
+      const unsigned pos = __builtin_ctz(open);
+      unsigned len = 0;
+      for (unsigned d = 0; d < 9; ++d) {
+        len += (bs->cand[d][b] >> pos) & 1;
+      }
+      if (len < prv) {
+        prv = len;
+        idx = b * 27 + pos;
+      }
+    }
+  }
+  STATS_SLOT(beg);
+  assert(idx != NOINDEX);
+
+  STATS_BRANCH(prv);
+
+  const unsigned band = idx / 27;
+  const uint32_t bit = 1u << (idx % 27);
+  for (unsigned d = 0; d < 9; ++d) {
+    if (bs->cand[d][band] & bit) {
+      struct sbits sub = *bs;
+      bits_place(&sub, idx, d);
+      STATS_DOWN();
+      if (bits_search(pl, &sub)) {
+        *bs = sub;
+        return true;
+      }
+      STATS_UP();
+    }
+  }
+
+  /* no solution found */
+  return false;
+}
+
+/**
+ * solves the puzzle with per-digit bitboards, single threaded
+ *
+ * @param  pl   the pool (budgets)
+ * @param  grid the sudoku grid
+ * @return      true if a solution was found, false otherwise
+ */
+static bool find_solution_bits (
+  struct spool *pl,
+  sud_cell grid[]
+) {
+  assert(grid != 0);
+  pthread_once(&bits_once, bits_setup);
+
+  struct sbits bs;
+  memset(&bs, 0, sizeof(bs));
+  for (unsigned b = 0; b < 3; ++b) {
+    bs.open[b] = BITS_BAND;
+    for (unsigned d = 0; d < 9; ++d) {
+      bs.cand[d][b] = BITS_BAND;
+    }
+  }
+
+  for (unsigned idx = 0; idx < SCELLS; ++idx) {
+    if (grid[idx]) {
+      const unsigned dig = grid[idx] - 1;
+      if (!(bs.cand[dig][idx / 27] & (1u << (idx % 27)))) {
+        /* givens contradict each other */
+        return false;
+      }
+      bits_place(&bs, idx, dig);
+    }
+  }
+
+  if (!bits_search(pl, &bs)) {
+    return false;
+  }
+
+  for (unsigned d = 0; d < 9; ++d) {
+    for (unsigned b = 0; b < 3; ++b) {
+      for (uint32_t done = bs.done[d][b]; done; done &= done - 1) {
+        grid[b * 27 + __builtin_ctz(done)] = d + 1;
+      }
+    }
+  }
+  return true;
+}
+#endif
+/**
+ * searches with the bitmask engine until `limit` solutions
+ * were counted, the state of the context then holds the last one
+ *
+ * @param  ctx   the context
+ * @param  grid  the sudoku grid
+ * @param  limit stop at this many solutions
+ * @return       true if the limit was reached, false otherwise
+ */
+static bool find_solutions (
+  struct sud_ctx *ctx,
+  const sud_cell grid[],
+  unsigned long limit
+) {
+  assert(ctx != 0);
+  assert(grid != 0);
+  struct spool *pl = &ctx->pool;
+  init_state(&ctx->st, grid);
+  pl->limit = limit;
+  atomic_store(&pl->count, 0);
+  if (pl->size > 0) {
+    /* multi-threaded */
+    return find_solution_mt(pl, &ctx->st);
+  }
+  /* single threaded, no worker to split for */
+  return find_solution_st(pl, 0, &ctx->st);
+}
+
+/**
+ * enumerates the solutions of a puzzle (single threaded)
+ *
+ * @param  st   the search state
+ * @param  grid the sudoku grid, not modified
+ * @param  en   the enumeration, `len` must be SUD_NOCURSOR or a cursor
+ * @return      true if stopped by the callback, false if done
+ */
+static bool enum_solutions (
+  struct sstate *st,
+  const sud_cell grid[],
+  struct sud_enum *en
+) {
+  assert(st != 0);
+  assert(grid != 0);
+  assert(en != 0);
+  assert(en->emit != 0);
+  init_state(st, grid);
+  if (en->len == SUD_NOCURSOR) {
+    /* from the start */
+    en->replay = 0;
+    en->skip = false;
+  } else {
+    /* follow the cursor, skip its solution */
+    en->replay = en->len;
+    en->skip = true;
+  }
+  return enum_solutions_st(st, en, 0);
+}
+
+unsigned sud_value (
+  char chr
+) {
+  #if SSIZE == 9
+    return chr >= '1' && chr <= '9' ? chr - '0' : 0;
+  #else
+    if (chr >= 'a' && chr <= 'z') {
+      chr -= 'a' - 'A';
+    }
+    const char *pos = memchr(SSYMBOLS, chr, SSIZE);
+    return pos ? pos - SSYMBOLS + 1 : 0;
+  #endif
+}
+
+char sud_symbol (
+  unsigned num
+) {
+  assert(num <= SSIZE);
+  return num ? SSYMBOLS[num - 1] : ' ';
+}
+
+/**
+ * finds and reports the first invalid or duplicate
+ * number of a grid, see `check_grid`
+ *
+ * @param  ctx  the context (error message)
+ * @param  grid the sudoku grid
+ * @return      SUD_OK, SUD_ESYNTAX or SUD_EDUP
+ */
+static int report_grid (
+  struct sud_ctx *ctx,
+  const sud_cell grid[]
+) {
+  assert(ctx != 0);
+  assert(grid != 0);
+  /* numbers seen so far */
+  sud_mask rows[SSIZE] = {0};
+  sud_mask cols[SSIZE] = {0};
+  sud_mask grps[SSIZE] = {0};
+
+  for (unsigned idx = 0; idx < SCELLS; ++idx) {
+    const unsigned val = grid[idx];
+    if (val == 0) {
+      /* empty slot */
+      continue;
+    }
+    const unsigned row = IDX_ROW(idx);
+    const unsigned col = IDX_COL(idx);
+    if (val > SSIZE) {
+      /* out of bounds */
+      whops(ctx, SUD_ESYNTAX,
+        "invalid number %u in row %u and column %u",
+        val, row + 1, col + 1
+      );
+    }
+    const char chr = sud_symbol(val);
+    const sud_mask bit = (sud_mask) 1 << val;
+    /* check if value is unique in current row */
+    if (rows[row] & bit) {
+      /* the first slot with the number is the other one */
+      unsigned oth = 0;
+      while (grid[row * SSIZE + oth] != val) {
+        oth += 1;
+      }
+      whops(ctx, SUD_EDUP,
+        "duplicate value %c in row %u (column %u)"
+        " - value already seen in column %u",
+        chr, row + 1, col + 1, oth + 1
+      );
+    }
+    /* check if value is unique in current column */
+    if (cols[col] & bit) {
+      unsigned oth = 0;
+      while (grid[oth * SSIZE + col] != val) {
+        oth += 1;
+      }
+      whops(ctx, SUD_EDUP,
+        "duplicate value %c in column %u (row %u)"
+        " - value already seen in row %u",
+        chr, col + 1, row + 1, oth + 1
+      );
+    }
+    /* check if value is unique in current group */
+    const unsigned grp = IDX_GRP(idx);
+    if (grps[grp] & bit) {
+      whops(ctx, SUD_EDUP,
+        "duplicate value %c in group %u "
+        "(row %u and column %u)",
+        chr, grp + 1, row + 1, col + 1
+      );
+    }
+    rows[row] |= bit;
+    cols[col] |= bit;
+    grps[grp] |= bit;
+  }
+  return SUD_OK;
+}
+
+/**
+ * checks the numbers of a grid, no number may be
+ * given twice in a row, column or group. the units
+ * collect their numbers in bitmasks without branches
+ *
+ * @param  grid the sudoku grid
+ * @return      false if a number is invalid or a duplicate
+ */
+static bool check_cells (
+  const sud_cell grid[]
+) {
+  assert(grid != 0);
+  sud_mask cols[SSIZE] = {0};
+  sud_mask grps[SSIZE] = {0};
+  sud_mask dup = 0;
+  unsigned big = 0;
+
+  for (unsigned row = 0, idx = 0; row < SSIZE; ++row) {
+    sud_mask rmsk = 0;
+    sud_mask *gmsk = grps + row / SBOX * SBOX;
+    for (unsigned box = 0, col = 0; box < SBOX; ++box) {
+      /* group of the next SBOX slots */
+      sud_mask gbox = gmsk[box];
+      for (unsigned off = 0; off < SBOX; ++off, ++col, ++idx) {
+        const unsigned val = grid[idx];
+        big |= val > SSIZE;
+        /* a empty slot has no bit */
+        const sud_mask bit =
+          (sud_mask) ((uint32_t) 1 << (val & 31)) & ALLCANDS;
+        dup |= (rmsk | cols[col] | gbox) & bit;
+        rmsk |= bit;
+        cols[col] |= bit;
+        gbox |= bit;
+      }
+      gmsk[box] = gbox;
+    }
+  }
+
+  return !big && !dup;
+}
+
+#if defined(SDISPATCH) && SBOX == 3
+/**
+ * `check_cells` with avx2, the first 8 slots of a row at a
+ * time. columns are checked per lane, rows and groups by
+ * comparing the numbers seen with the filled slots
+ *
+ * @param  grid the sudoku grid
+ * @return      false if a number is invalid or a duplicate
+ */
+STARGET("avx2,popcnt") static bool check_cells_avx2 (
+  const sud_cell grid[]
+) {
+  assert(grid != 0);
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i nine = _mm256_set1_epi32(9);
+  const __m256i all = _mm256_set1_epi32(ALLCANDS);
+  const __m256i nul = _mm256_setzero_si256();
+  /* numbers of the first 8 columns and of the current band */
+  __m256i cols = nul;
+  __m256i band = nul;
+  /* invalid numbers and duplicates of the columns */
+  __m256i bad = nul;
+  /* the same for the 9th column */
+  sud_mask col8 = 0;
+  sud_mask band8 = 0;
+  bool dup = false;
+  /* filled slots of the groups of the band */
+  unsigned cnt[3] = {0};
+  alignas(32) uint32_t lane[8];
+
+  for (unsigned row = 0; row < 9; ++row) {
+    const sud_cell *cells = &grid[row * 9];
+    const __m256i val = _mm256_cvtepu8_epi32(
+      _mm_loadl_epi64((const __m128i *) cells)
+    );
+    /* a empty slot has no bit */
+    const __m256i bits = _mm256_and_si256(_mm256_sllv_epi32(one, val), all);
+    bad = _mm256_or_si256(bad, _mm256_or_si256(
+      _mm256_cmpgt_epi32(val, nine),
+      _mm256_and_si256(cols, bits)
+    ));
+    cols = _mm256_or_si256(cols, bits);
+    band = _mm256_or_si256(band, bits);
+    /* 9th slot */
+    const unsigned val8 = cells[8];
+    const sud_mask bit8 = (sud_mask) ((uint32_t) 1 << (val8 & 31)) & ALLCANDS;
+    dup |= val8 > 9 || (col8 & bit8);
+    col8 |= bit8;
+    band8 |= bit8;
+    /* filled slots */
+    const unsigned full = _mm256_movemask_ps(
+      _mm256_castsi256_ps(_mm256_cmpgt_epi32(bits, nul))
+    );
+    cnt[0] += __builtin_popcount(full & 0x07);
+    cnt[1] += __builtin_popcount(full & 0x38);
+    cnt[2] += __builtin_popcount(full & 0xC0) + (bit8 != 0);
+    /* a row has a duplicate if it has less numbers than slots */
+    _mm256_store_si256((__m256i *) lane, bits);
+    sud_mask rmsk = bit8;
+    for (unsigned col = 0; col < 8; ++col) {
+      rmsk |= lane[col];
+    }
+    dup |= (unsigned) __builtin_popcount(rmsk) !=
+      (unsigned) __builtin_popcount(full) + (bit8 != 0);
+    if (row % 3 == 2) {
+      /* the same for the groups of the band */
+      _mm256_store_si256((__m256i *) lane, band);
+      const sud_mask g0 = lane[0] | lane[1] | lane[2];
+      const sud_mask g1 = lane[3] | lane[4] | lane[5];
+      const sud_mask g2 = lane[6] | lane[7] | band8;
+      dup |= (unsigned) __builtin_popcount(g0) != cnt[0];
+      dup |= (unsigned) __builtin_popcount(g1) != cnt[1];
+      dup |= (unsigned) __builtin_popcount(g2) != cnt[2];
+      band = nul;
+      band8 = 0;
+      cnt[0] = cnt[1] = cnt[2] = 0;
+    }
+  }
+  return !dup && _mm256_testz_si256(bad, bad);
+}
+#endif
+
+/**
+ * checks the numbers of a grid with the check kernel, the
+ * error is only looked up if the kernel found one
+ *
+ * @param  ctx  the context (error message)
+ * @param  grid the sudoku grid
+ * @return      SUD_OK, SUD_ESYNTAX or SUD_EDUP
+ */
+static int check_grid (
+  struct sud_ctx *ctx,
+  const sud_cell grid[]
+) {
+  assert(ctx != 0);
+  assert(grid != 0);
+  if (!skern.check(grid)) {
+    return report_grid(ctx, grid);
+  }
+  return SUD_OK;
+}
+
+/**
+ * checks if a character is a empty slot, "0" is a
+ * number in 16*16 grids
+ *
+ * @param  chr the character
+ * @return     true for a space, "." or "0"
+ */
+static inline bool is_blank (
+  char chr
+) {
+  return chr == ' ' || chr == '.' || (SSIZE != 16 && chr == '0');
+}
+
+/**
+ * converts the characters of a grid
+ *
+ * @param  grid the sudoku grid (output)
+ * @param  buf  SCELLS characters
+ * @return      false if a character is invalid
+ */
+static bool classify_cells (
+  sud_cell grid[],
+  const char buf[]
+) {
+  assert(grid != 0);
+  assert(buf != 0);
+  for (unsigned idx = 0; idx < SCELLS; ++idx) {
+    const char chr = buf[idx];
+    if (is_blank(chr)) {
+      grid[idx] = 0;
+      continue;
+    }
+    grid[idx] = sud_value(chr);
+    if (grid[idx] == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+#if defined(SDISPATCH) && SBOX == 3
+/**
+ * converts the characters of a 9*9 grid 16 at a time,
+ * blanks and digits are told apart with a few compares
+ *
+ * @param  grid the sudoku grid (output)
+ * @param  buf  SCELLS characters
+ * @return      false if a character is invalid
+ */
+STARGET("sse2") static bool classify_cells_sse2 (
+  sud_cell grid[],
+  const char buf[]
+) {
+  assert(grid != 0);
+  assert(buf != 0);
+  const __m128i zero = _mm_set1_epi8('0');
+  const __m128i nine = _mm_set1_epi8(9);
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i dot = _mm_set1_epi8('.');
+  __m128i bad = _mm_setzero_si128();
+  unsigned idx = 0;
+
+  for (; idx + 16 <= SCELLS; idx += 16) {
+    const __m128i chr = _mm_loadu_si128((const __m128i *) (buf + idx));
+    /* "0" to "9" wrap to 0 to 9, everything else is larger */
+    const __m128i val = _mm_sub_epi8(chr, zero);
+    const __m128i dig = _mm_cmpeq_epi8(_mm_min_epu8(val, nine), val);
+    const __m128i blk = _mm_or_si128(
+      _mm_cmpeq_epi8(chr, space),
+      _mm_cmpeq_epi8(chr, dot)
+    );
+    bad = _mm_or_si128(bad, _mm_cmpeq_epi8(
+      _mm_or_si128(dig, blk), _mm_setzero_si128()
+    ));
+    _mm_storeu_si128((__m128i *) (grid + idx), _mm_and_si128(val, dig));
+  }
+  if (_mm_movemask_epi8(bad) != 0) {
+    return false;
+  }
+
+  for (; idx < SCELLS; ++idx) {
+    const char chr = buf[idx];
+    if (is_blank(chr)) {
+      grid[idx] = 0;
+    } else if (chr >= '1' && chr <= '9') {
+      grid[idx] = chr - '0';
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * `classify_cells_sse2` with avx2, 32 characters at a time
+ *
+ * @param  grid the sudoku grid (output)
+ * @param  buf  SCELLS characters
+ * @return      false if a character is invalid
+ */
+STARGET("avx2") static bool classify_cells_avx2 (
+  sud_cell grid[],
+  const char buf[]
+) {
+  assert(grid != 0);
+  assert(buf != 0);
+  const __m256i zero = _mm256_set1_epi8('0');
+  const __m256i nine = _mm256_set1_epi8(9);
+  const __m256i space = _mm256_set1_epi8(' ');
+  const __m256i dot = _mm256_set1_epi8('.');
+  __m256i bad = _mm256_setzero_si256();
+  unsigned idx = 0;
+
+  for (; idx + 32 <= SCELLS; idx += 32) {
+    const __m256i chr = _mm256_loadu_si256((const __m256i *) (buf + idx));
+    /* "0" to "9" wrap to 0 to 9, everything else is larger */
+    const __m256i val = _mm256_sub_epi8(chr, zero);
+    const __m256i dig = _mm256_cmpeq_epi8(_mm256_min_epu8(val, nine), val);
+    const __m256i blk = _mm256_or_si256(
+      _mm256_cmpeq_epi8(chr, space),
+      _mm256_cmpeq_epi8(chr, dot)
+    );
+    bad = _mm256_or_si256(bad, _mm256_cmpeq_epi8(
+      _mm256_or_si256(dig, blk), _mm256_setzero_si256()
+    ));
+    _mm256_storeu_si256((__m256i *) (grid + idx), _mm256_and_si256(val, dig));
+  }
+  if (!_mm256_testz_si256(bad, bad)) {
+    return false;
+  }
+
+  for (; idx < SCELLS; ++idx) {
+    const char chr = buf[idx];
+    if (is_blank(chr)) {
+      grid[idx] = 0;
+    } else if (chr >= '1' && chr <= '9') {
+      grid[idx] = chr - '0';
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+#endif
+
+/**
+ * parses and validates the grid characters
+ *
+ * @param  ctx  the context (error message)
+ * @param  grid the sudoku grid (output)
+ * @param  buf  SCELLS characters, row by row without newlines
+ * @return      SUD_OK, SUD_ESYNTAX or SUD_EDUP
+ */
+static int parse_cells (
+  struct sud_ctx *ctx,
+  sud_cell grid[],
+  const char buf[]
+) {
+  assert(ctx != 0);
+  assert(grid != 0);
+  assert(buf != 0);
+  if (skern.classify(grid, buf)) {
+    return check_grid(ctx, grid);
+  }
+  /* find the invalid character */
+  for (unsigned idx = 0; idx < SCELLS; ++idx) {
+    const char chr = buf[idx];
+    if (is_blank(chr)) {
+      /* empty slot */
+      grid[idx] = 0;
+      continue;
+    }
+    /* get unsigned number from character */
+    grid[idx] = sud_value(chr);
+    if (grid[idx] == 0) {
+      /* out of bounds */
+      whops(ctx, SUD_ESYNTAX,
+        "invalid value `%c` (%i) in row %u and column %u",
+        chr, chr, IDX_ROW(idx) + 1, IDX_COL(idx) + 1
+      );
+    }
+  }
+  return check_grid(ctx, grid);
+}
+
+/**
+ * returns the length of the first line of a buffer
+ *
+ * @param  buf  the buffer
+ * @param  len  length of the buffer
+ * @param  next length including the line break (output)
+ * @return      length without the line break
+ */
+static size_t line_length (
+  const char *buf,
+  size_t len,
+  size_t *next
+) {
+  assert(buf != 0);
+  assert(next != 0);
+  const char *end = memchr(buf, '\n', len);
+  size_t cnt = end ? (size_t) (end - buf) : len;
+  *next = end ? cnt + 1 : cnt;
+  if (cnt > 0 && buf[cnt - 1] == '\r') {
+    /* windows line break */
+    cnt -= 1;
+  }
+  return cnt;
+}
+
+/* column orders of the canonical search, transposition included */
+#if SBOX == 3
+  /* 6 stack orders * 6^3 column orders within the stacks */
+  #define SPERMS 1296
+  #define SFLIPS 2
+#else
+  /* rows and bands only, larger grids have too many column orders */
+  #define SPERMS 1
+  #define SFLIPS 1
+#endif
+
+/* 64 bit words of a set of column orders */
+#define SPERMW ((SPERMS + 63) / 64)
+
+/* partial transforms per level before the cache is bypassed */
+#define SCANMAX 4096
+
+/* row evaluations per grid before the cache is bypassed */
+#define SCANWORK (1ul << 16)
+
+/* no entry in a bucket of the cache */
+#define NOENTRY UINT32_MAX
+
+/**
+ * a partial transform of the canonical search: the rows taken
+ * so far and all column orders that give the same clue pattern
+ */
+struct scanon {
+  /* original row of each canonical row */
+  uint8_t rows[SSIZE];
+  /* bitmask of the taken rows */
+  uint32_t used;
+  /* transposed grid */
+  bool flip;
+  /* column orders, bit per entry of `canon_perms` */
+  uint64_t perms[SPERMW];
+};
+
+/**
+ * a transform from a grid to its canonical form
+ */
+struct strans {
+  /* original row of each canonical row */
+  uint8_t rows[SSIZE];
+  /* transposed grid */
+  bool flip;
+  /* column order, entry of `canon_perms` */
+  unsigned perm;
+  /* canonical number of each original number, 0 if not given */
+  uint8_t map[SSIZE + 1];
+  /* next canonical number */
+  uint8_t next;
+};
+
+/**
+ * a cached result, the puzzle and its solution are
+ * stored in canonical form
+ */
+struct sentry {
+  sud_cell key[SCELLS];
+  sud_cell sol[SCELLS];
+  uint64_t hash;
+  /* next entry of the bucket */
+  uint32_t next;
+  /* the puzzle has no solution */
+  bool nosol;
+  /* recently used, cleared by the clock hand */
+  bool ref;
+};
+
+/**
+ * result cache, shared by any number of contexts
+ */
+struct sud_cache {
+  pthread_mutex_t mtx;
+  /* entries, filled up once and then replaced by the clock */
+  struct sentry *ents;
+  unsigned long size;
+  unsigned long len;
+  unsigned long hand;
+  /* hash buckets, a power of two */
+  uint32_t *heads;
+  unsigned long mask;
+  /* counters of `sud_cache_info` */
+  unsigned long hits;
+  unsigned long misses;
+  unsigned long bypass;
+  unsigned long evicted;
+};
+
+/* original column of each canonical column per column order */
+static uint8_t canon_perms[SPERMS][SSIZE];
+
+#if SBOX == 3
+/* a stack of 3 clue bits in the order of a column order, first column
+ * first, per column order within a stack (see `canon_setup`) */
+static uint8_t canon_stack[6][8];
+#endif
+
+/* `canon_perms` is built once */
+static pthread_once_t canon_once = PTHREAD_ONCE_INIT;
+
+/**
+ * builds the column orders, called once
+ *
+ */
+static void canon_setup ()
+{
+  #if SBOX == 3
+    static const uint8_t ords[6][3] = {
+      {0,1,2}, {0,2,1}, {1,0,2}, {1,2,0}, {2,0,1}, {2,1,0}
+    };
+    unsigned num = 0;
+    for (unsigned stk = 0; stk < 6; ++stk) {
+      for (unsigned ca = 0; ca < 6; ++ca) {
+        for (unsigned cb = 0; cb < 6; ++cb) {
+          for (unsigned cc = 0; cc < 6; ++cc) {
+            const unsigned cols[3] = {ca, cb, cc};
+            for (unsigned col = 0; col < SSIZE; ++col) {
+              const unsigned box = ords[stk][col / 3];
+              canon_perms[num][col] = box * 3 + ords[cols[col / 3]][col % 3];
+            }
+            num += 1;
+          }
+        }
+      }
+    }
+    for (unsigned ord = 0; ord < 6; ++ord) {
+      for (unsigned bits = 0; bits < 8; ++bits) {
+        for (unsigned col = 0; col < 3; ++col) {
+          canon_stack[ord][bits] |= (bits >> ords[ord][col] & 1) << (2 - col);
+        }
+      }
+    }
+  #else
+    for (unsigned col = 0; col < SSIZE; ++col) {
+      canon_perms[0][col] = col;
+    }
+  #endif
+}
+
+/**
+ * returns the clue pattern of a row in a column order,
+ * the first column is the highest bit
+ *
+ * @param  mask the clues of the row, bit per column
+ * @param  prm  the column order
+ * @return      the pattern
+ */
+static inline uint32_t canon_pattern (
+  uint32_t mask,
+  unsigned prm
+) {
+  #if SBOX == 3
+    /* stack order and the orders within the 3 stacks */
+    const uint8_t *cols = canon_perms[prm];
+    return
+      canon_stack[prm / 36 % 6][mask >> (cols[0] / 3 * 3) & 7] << 6 |
+      canon_stack[prm / 6 % 6][mask >> (cols[3] / 3 * 3) & 7] << 3 |
+      canon_stack[prm % 6][mask >> (cols[6] / 3 * 3) & 7];
+  #else
+    uint32_t res = 0;
+    for (unsigned col = 0; col < SSIZE; ++col) {
+      res = res << 1 | (mask >> canon_perms[prm][col] & 1);
+    }
+    return res;
+  #endif
+}
+
+/**
+ * returns the smallest clue pattern of a row in any column
+ * order: emptier stacks first, empty slots first in a stack
+ *
+ * @param  mask the clues of the row, bit per column
+ * @return      the pattern
+ */
+static inline uint32_t canon_least (
+  uint32_t mask
+) {
+  #if SBOX == 3
+    unsigned cnt[3];
+    for (unsigned stk = 0; stk < 3; ++stk) {
+      cnt[stk] = __builtin_popcount(mask >> (stk * 3) & 7);
+    }
+    /* sort the 3 counts */
+    unsigned tmp;
+    if (cnt[0] > cnt[1]) { tmp = cnt[0]; cnt[0] = cnt[1]; cnt[1] = tmp; }
+    if (cnt[1] > cnt[2]) { tmp = cnt[1]; cnt[1] = cnt[2]; cnt[2] = tmp; }
+    if (cnt[0] > cnt[1]) { tmp = cnt[0]; cnt[0] = cnt[1]; cnt[1] = tmp; }
+    return ((1u << cnt[0]) - 1) << 6 | ((1u << cnt[1]) - 1) << 3 |
+      ((1u << cnt[2]) - 1);
+  #else
+    return canon_pattern(mask, 0);
+  #endif
+}
+
+/**
+ * finds the canonical form of a grid. of all grids that are the
+ * same puzzle after swapping bands, rows within bands, stacks,
+ * columns within stacks and transposing, the ones with the
+ * smallest clue pattern (read row by row, empty slots first) are
+ * searched a row at a time. the smallest of them after
+ * renumbering the numbers in order of appearance is the form
+ *
+ * @param  ctx  the context (search memory)
+ * @param  grid the sudoku grid
+ * @param  key  the canonical form (output)
+ * @param  trf  the transform from the grid to its form (output)
+ * @return      false if the search was given up
+ */
+static bool canon_grid (
+  struct sud_ctx *ctx,
+  const sud_cell grid[],
+  sud_cell key[],
+  struct strans *trf
+) {
+  assert(ctx != 0);
+  assert(ctx->canon != 0);
+  pthread_once(&canon_once, canon_setup);
+  struct scanon *cur = ctx->canon;
+  struct scanon *nxt = ctx->canon + SCANMAX;
+  unsigned long work = 0;
+  unsigned ncur = 0;
+
+  /* clues per row of the grid and of the transposed grid */
+  uint32_t masks[SFLIPS][SSIZE] = {{0}};
+  for (unsigned idx = 0; idx < SCELLS; ++idx) {
+    if (grid[idx]) {
+      masks[0][IDX_ROW(idx)] |= 1u << IDX_COL(idx);
+      if (SFLIPS > 1) {
+        masks[SFLIPS - 1][IDX_COL(idx)] |= 1u << IDX_ROW(idx);
+      }
+    }
+  }
+
+  for (unsigned flip = 0; flip < SFLIPS; ++flip) {
+    /* all column orders, no rows yet */
+    struct scanon *cn = &cur[ncur++];
+    memset(cn, 0, sizeof(*cn));
+    cn->flip = flip;
+    memset(cn->perms, 0xFF, sizeof(cn->perms));
+    if (SPERMS % 64) {
+      cn->perms[SPERMW - 1] = (1ull << (SPERMS % 64)) - 1;
+    }
+  }
+
+  /* smallest clue pattern, row by row */
+  for (unsigned lvl = 0; lvl < SSIZE; ++lvl) {
+    uint32_t best = 0;
+    bool have = false;
+    unsigned nnxt = 0;
+
+    if (lvl == 0) {
+      /* all column orders are left, a row can be as small as its bound */
+      best = UINT32_MAX;
+      for (unsigned flip = 0; flip < SFLIPS; ++flip) {
+        for (unsigned row = 0; row < SSIZE; ++row) {
+          const uint32_t least = canon_least(masks[flip][row]);
+          best = least < best ? least : best;
+        }
+      }
+      have = true;
+    }
+
+    for (unsigned num = 0; num < ncur; ++num) {
+      const struct scanon *cn = &cur[num];
+      /* a new band starts with any row of a unused band */
+      const unsigned beg = lvl % SBOX ? cn->rows[lvl - 1] / SBOX * SBOX : 0;
+      const unsigned end = lvl % SBOX ? beg + SBOX : SSIZE;
+
+      for (unsigned row = beg; row < end; ++row) {
+        if (cn->used & (1u << row)) {
+          continue;
+        }
+        const uint32_t mask = masks[cn->flip][row];
+        if (have && canon_least(mask) > best) {
+          /* can not be the smallest row */
+          continue;
+        }
+        struct scanon *nw = 0;
+        for (unsigned wrd = 0; wrd < SPERMW; ++wrd) {
+          for (uint64_t bits = cn->perms[wrd]; bits; bits &= bits - 1) {
+            const unsigned prm = wrd * 64 + __builtin_ctzll(bits);
+            const uint32_t pat = canon_pattern(mask, prm);
+            if (++work > SCANWORK) {
+              return false;
+            }
+            if (have && pat > best) {
+              continue;
+            }
+            if (!have || pat < best) {
+              /* new smallest row, all other transforms are dropped */
+              best = pat;
+              have = true;
+              nnxt = 0;
+              nw = 0;
+            }
+            if (!nw) {
+              if (nnxt == SCANMAX) {
+                return false;
+              }
+              nw = &nxt[nnxt++];
+              memcpy(nw->rows, cn->rows, sizeof(nw->rows));
+              nw->rows[lvl] = row;
+              nw->used = cn->used | 1u << row;
+              nw->flip = cn->flip;
+              memset(nw->perms, 0, sizeof(nw->perms));
+            }
+            nw->perms[wrd] |= 1ull << (prm % 64);
+          }
+        }
+      }
+    }
+
+    struct scanon *tmp = cur;
+    cur = nxt;
+    nxt = tmp;
+    ncur = nnxt;
+  }
+
+  /* smallest numbers of the transforms left */
+  bool have = false;
+  for (unsigned num = 0; num < ncur; ++num) {
+    const struct scanon *cn = &cur[num];
+    for (unsigned wrd = 0; wrd < SPERMW; ++wrd) {
+      for (uint64_t bits = cn->perms[wrd]; bits; bits &= bits - 1) {
+        const unsigned prm = wrd * 64 + __builtin_ctzll(bits);
+        const uint8_t *cols = canon_perms[prm];
+        if (++work > SCANWORK) {
+          return false;
+        }
+
+        /* renumbered and compared on the fly */
+        struct strans tr;
+        memset(tr.map, 0, sizeof(tr.map));
+        tr.next = 1;
+        int cmp = have ? 0 : -1;
+        for (unsigned idx = 0; idx < SCELLS && cmp <= 0; ++idx) {
+          const unsigned row = cn->rows[IDX_ROW(idx)];
+          const unsigned col = cols[IDX_COL(idx)];
+          const unsigned val = cn->flip
+            ? grid[col * SSIZE + row]
+            : grid[row * SSIZE + col];
+          if (val && !tr.map[val]) {
+            tr.map[val] = tr.next++;
+          }
+          if (cmp == 0 && tr.map[val] != key[idx]) {
+            cmp = tr.map[val] < key[idx] ? -1 : 1;
+          }
+          if (cmp < 0) {
+            key[idx] = tr.map[val];
+          }
+        }
+        if (cmp < 0) {
+          memcpy(tr.rows, cn->rows, sizeof(tr.rows));
+          tr.flip = cn->flip;
+          tr.perm = prm;
+          *trf = tr;
+          have = true;
+        }
+      }
+    }
+  }
+  return have;
+}
+
+/**
+ * numbers the original numbers a grid does not contain,
+ * in order after the ones it does
+ *
+ * @param trf the transform
+ * @param map canonical number of each original number (output)
+ * @param inv original number of each canonical number (output)
+ */
+static void canon_numbers (
+  const struct strans *trf,
+  uint8_t map[],
+  uint8_t inv[]
+) {
+  unsigned next = trf->next;
+  map[0] = 0;
+  inv[0] = 0;
+  for (unsigned val = 1; val <= SSIZE; ++val) {
+    map[val] = trf->map[val] ? trf->map[val] : next++;
+    inv[map[val]] = val;
+  }
+}
+
+/**
+ * returns the original index of a canonical slot
+ *
+ * @param  trf the transform
+ * @param  idx the canonical index
+ * @return     the original index
+ */
+static inline unsigned canon_index (
+  const struct strans *trf,
+  unsigned idx
+) {
+  const unsigned row = trf->rows[IDX_ROW(idx)];
+  const unsigned col = canon_perms[trf->perm][IDX_COL(idx)];
+  return trf->flip ? col * SSIZE + row : row * SSIZE + col;
+}
+
+/**
+ * returns the hash of a canonical form (fnv-1a)
+ *
+ * @param  key the canonical form
+ * @return     the hash
+ */
+static uint64_t canon_hash (
+  const sud_cell key[]
+) {
+  uint64_t hash = 0xCBF29CE484222325ull;
+  for (unsigned idx = 0; idx < SCELLS; ++idx) {
+    hash = (hash ^ key[idx]) * 0x100000001B3ull;
+  }
+  return hash;
+}
+
+/**
+ * looks up a canonical form, counts a hit or miss
+ *
+ * @param  cache the cache
+ * @param  key   the canonical form
+ * @param  hash  its hash
+ * @param  sol   the canonical solution (output)
+ * @param  nosol true if there is no solution (output)
+ * @return       true on a hit
+ */
+static bool cache_find (
+  struct sud_cache *cache,
+  const sud_cell key[],
+  uint64_t hash,
+  sud_cell sol[],
+  bool *nosol
+) {
+  bool hit = false;
+  pthread_mutex_lock(&cache->mtx);
+  uint32_t num = cache->heads[hash & cache->mask];
+  while (num != NOENTRY) {
+    struct sentry *ent = &cache->ents[num];
+    if (ent->hash == hash && memcmp(ent->key, key, SCELLS) == 0) {
+      memcpy(sol, ent->sol, SCELLS);
+      *nosol = ent->nosol;
+      ent->ref = true;
+      hit = true;
+      break;
+    }
+    num = ent->next;
+  }
+  if (hit) {
+    cache->hits += 1;
+  } else {
+    cache->misses += 1;
+  }
+  pthread_mutex_unlock(&cache->mtx);
+  return hit;
+}
+
+/**
+ * stores a result, the clock hand replaces the first entry
+ * that was not used since its last round once the cache is full
+ *
+ * @param cache the cache
+ * @param key   the canonical form
+ * @param hash  its hash
+ * @param sol   the canonical solution
+ * @param nosol true if there is no solution
+ */
+static void cache_store (
+  struct sud_cache *cache,
+  const sud_cell key[],
+  uint64_t hash,
+  const sud_cell sol[],
+  bool nosol
+) {
+  pthread_mutex_lock(&cache->mtx);
+  uint32_t *head = &cache->heads[hash & cache->mask];
+  for (uint32_t num = *head; num != NOENTRY; num = cache->ents[num].next) {
+    const struct sentry *ent = &cache->ents[num];
+    if (ent->hash == hash && memcmp(ent->key, key, SCELLS) == 0) {
+      /* stored by another thread */
+      pthread_mutex_unlock(&cache->mtx);
+      return;
+    }
+  }
+
+  unsigned long num;
+  if (cache->len < cache->size) {
+    num = cache->len++;
+  } else {
+    while (cache->ents[cache->hand].ref) {
+      cache->ents[cache->hand].ref = false;
+      cache->hand = (cache->hand + 1) % cache->size;
+    }
+    num = cache->hand;
+    cache->hand = (cache->hand + 1) % cache->size;
+    /* unlink the old entry */
+    const struct sentry *old = &cache->ents[num];
+    uint32_t *lnk = &cache->heads[old->hash & cache->mask];
+    while (*lnk != num) {
+      lnk = &cache->ents[*lnk].next;
+    }
+    *lnk = old->next;
+    cache->evicted += 1;
+  }
+
+  struct sentry *ent = &cache->ents[num];
+  memcpy(ent->key, key, SCELLS);
+  if (!nosol) {
+    memcpy(ent->sol, sol, SCELLS);
+  }
+  ent->hash = hash;
+  ent->nosol = nosol;
+  ent->ref = false;
+  ent->next = *head;
+  *head = num;
+  pthread_mutex_unlock(&cache->mtx);
+}
+
+/**
+ * solves a puzzle with the engine of the context
+ *
+ * @param  ctx  the context
+ * @param  grid the grid, solved on success
+ * @return      SUD_OK, SUD_NOSOL or SUD_LIMIT
+ */
+static int solve_engine (
+  struct sud_ctx *ctx,
+  sud_cell grid[]
+) {
+  bool res;
+  switch (ctx->conf.engine) {
+    case SUD_DLX:
+      /* exact cover */
+      res = find_solution_dlx(&ctx->dx, &ctx->pool, grid);
+      break;
+    #if SBOX == 3
+      case SUD_BITS:
+        /* bitboards */
+        res = find_solution_bits(&ctx->pool, grid);
+        break;
+    #endif
+    default:
+      /* first solution, start xxx (badword on github) */
+      res = find_solutions(ctx, grid, 1);
+      if (res) {
+        /* copy solution back */
+        memcpy(grid, ctx->st.grid, sizeof(ctx->st.grid));
+      }
+      break;
+  }
+  if (!res && atomic_load(&ctx->pool.spent)) {
+    /* gave up, there may be a solution */
+    return SUD_LIMIT;
+  }
+  return res ? SUD_OK : SUD_NOSOL;
+}
+
+/**
+ * solves a puzzle through the cache of the context. a hit
+ * maps the cached solution back onto the grid, a miss
+ * solves the grid and stores its canonical solution
+ *
+ * @param  ctx  the context
+ * @param  grid the grid, solved on success
+ * @return      SUD_OK, SUD_NOSOL or SUD_LIMIT
+ */
+static int cache_solve (
+  struct sud_ctx *ctx,
+  sud_cell grid[]
+) {
+  struct sud_cache *cache = ctx->conf.cache;
+  struct strans trf = {0};
+  sud_cell key[SCELLS];
+  if (!canon_grid(ctx, grid, key, &trf)) {
+    /* too symmetric, e.g. a nearly empty grid */
+    pthread_mutex_lock(&cache->mtx);
+    cache->bypass += 1;
+    pthread_mutex_unlock(&cache->mtx);
+    return solve_engine(ctx, grid);
+  }
+
+  uint8_t map[SSIZE + 1];
+  uint8_t inv[SSIZE + 1];
+  canon_numbers(&trf, map, inv);
+  const uint64_t hash = canon_hash(key);
+  sud_cell sol[SCELLS];
+  bool nosol;
+
+  if (cache_find(cache, key, hash, sol, &nosol)) {
+    if (nosol) {
+      return SUD_NOSOL;
+    }
+    for (unsigned idx = 0; idx < SCELLS; ++idx) {
+      grid[canon_index(&trf, idx)] = inv[sol[idx]];
+    }
+    return SUD_OK;
+  }
+
+  const int res = solve_engine(ctx, grid);
+  if (res == SUD_LIMIT) {
+    /* nothing known */
+    return res;
+  }
+  if (res == SUD_OK) {
+    for (unsigned idx = 0; idx < SCELLS; ++idx) {
+      sol[idx] = map[grid[canon_index(&trf, idx)]];
+    }
+  }
+  cache_store(cache, key, hash, sol, res != SUD_OK);
+  return res;
+}
+
+int sud_parse (
+  struct sud_ctx *ctx,
+  sud_cell grid[],
+  const char *buf,
+  size_t len,
+  size_t *used
+) {
+  assert(ctx != 0);
+  assert(grid != 0);
+  assert(buf != 0 || len == 0);
+  assert(used != 0);
+  char cells[SCELLS];
+  const char *src = cells;
+  size_t pos = 0;
+  size_t next;
+  size_t cnt;
+
+  /* empty lines between grids */
+  for (;;) {
+    if (pos == len) {
+      *used = pos;
+      whops(ctx, SUD_MORE, "end of input");
+    }
+    cnt = line_length(buf + pos, len - pos, &next);
+    if (cnt > 0) {
+      break;
+    }
+    pos += next;
+  }
+  *used = pos;
+
+  if (cnt == SCELLS) {
+    /* one line format, parsed in place */
+    src = buf + pos;
+    pos += next;
+  } else if (cnt == SSIZE) {
+    /* SSIZE lines format */
+    for (unsigned row = 0; row < SSIZE; ++row) {
+      if (pos == len) {
+        whops(ctx, SUD_MORE, "premature end of input in row %u", row + 1);
+      }
+      cnt = line_length(buf + pos, len - pos, &next);
+      if (cnt != SSIZE) {
+        whops(ctx, SUD_ESYNTAX,
+          "unexpected length %zu of row %u (expected %u)",
+          cnt, row + 1, SSIZE
+        );
+      }
+      memcpy(cells + row * SSIZE, buf + pos, SSIZE);
+      pos += next;
+    }
+  } else {
+    whops(ctx, SUD_ESYNTAX,
+      "unexpected line length %zu (expected %u or %u)",
+      cnt, SSIZE, SCELLS
+    );
+  }
+
+  const int res = parse_cells(ctx, grid, src);
+  if (res == SUD_OK) {
+    *used = pos;
+  }
+  return res;
+}
+
+int sud_solve (
+  struct sud_ctx *ctx,
+  sud_cell grid[]
+) {
+  assert(ctx != 0);
+  assert(grid != 0);
+  const int err = check_grid(ctx, grid);
+  if (err != SUD_OK) {
+    return err;
+  }
+  #if defined(SSTATS)
+    sstats = &ctx->stats;
+  #endif
+  STATS_ROOT();
+  budget_start(&ctx->pool, &ctx->conf);
+  const unsigned long base = snodes;
+  const int res = ctx->conf.cache
+    ? cache_solve(ctx, grid)
+    : solve_engine(ctx, grid);
+  ctx->nodes = snodes - base;
+  return res;
+}
+
+int sud_count (
+  struct sud_ctx *ctx,
+  const sud_cell grid[],
+  unsigned long limit,
+  unsigned long *cnt
+) {
+  assert(ctx != 0);
+  assert(grid != 0);
+  assert(cnt != 0);
+  if (ctx->conf.engine != SUD_MASK) {
+    whops(ctx, SUD_EINVAL, "counting requires the bitmask engine");
+  }
+  if (limit == 0) {
+    whops(ctx, SUD_EINVAL, "the limit must be positive");
+  }
+  const int err = check_grid(ctx, grid);
+  if (err != SUD_OK) {
+    return err;
+  }
+  #if defined(SSTATS)
+    sstats = &ctx->stats;
+  #endif
+  STATS_ROOT();
+  budget_start(&ctx->pool, &ctx->conf);
+  const unsigned long base = snodes;
+  const bool done = find_solutions(ctx, grid, limit);
+  ctx->nodes = snodes - base;
+  /* workers may count past the limit */
+  const unsigned long num = atomic_load(&ctx->pool.count);
+  *cnt = num < limit ? num : limit;
+  if (!done && atomic_load(&ctx->pool.spent)) {
+    /* gave up, there may be more */
+    return SUD_LIMIT;
+  }
+  return SUD_OK;
+}
+
+int sud_enum (
+  struct sud_ctx *ctx,
+  const sud_cell grid[],
+  struct sud_enum *en
+) {
+  assert(ctx != 0);
+  assert(grid != 0);
+  assert(en != 0);
+  if (ctx->conf.engine != SUD_MASK) {
+    whops(ctx, SUD_EINVAL, "enumerating requires the bitmask engine");
+  }
+  if (!en->emit || en->len > SUD_NOCURSOR) {
+    whops(ctx, SUD_EINVAL, "invalid enumeration");
+  }
+  for (unsigned dep = 0; en->len != SUD_NOCURSOR && dep < en->len; ++dep) {
+    if (en->path[dep] == 0 || en->path[dep] > SSIZE) {
+      whops(ctx, SUD_EINVAL, "invalid cursor at depth %u", dep);
+    }
+  }
+  const int err = check_grid(ctx, grid);
+  if (err != SUD_OK) {
+    return err;
+  }
+  #if defined(SSTATS)
+    sstats = &ctx->stats;
+  #endif
+  STATS_ROOT();
+  const unsigned long base = snodes;
+  const bool res = enum_solutions(&ctx->st, grid, en);
+  ctx->nodes = snodes - base;
+  return res ? SUD_STOP : SUD_OK;
+}
+
+/**
+ * logic state of the rating, unlike the search state
+ * the candidates of every slot are kept explicitly
+ */
+struct srate {
+  sud_cell grid[SCELLS];
+  /* candidates per slot, 0 for filled slots */
+  sud_mask cans[SCELLS];
+  /* number of empty slots */
+  unsigned left;
+  /* true if the candidates contradict each other */
+  bool dead;
+};
+
+/**
+ * a set of n masks with n bits together, see `rate_combo`
+ */
+struct scombo {
+  struct srate *rs;
+  /* the masks to pick from */
+  uint32_t msk[SSIZE];
+  /* size of the set */
+  unsigned n;
+  /* unit or number of the masks */
+  unsigned arg;
+  /* applies a set, returns true if something was eliminated */
+  bool (*apply)(struct scombo *cb, uint32_t pick, uint32_t uni);
+};
+
+/**
+ * places a number and removes it from the candidates
+ * of its row, column and group
+ *
+ * @param rs  the logic state
+ * @param idx the index in the grid
+ * @param num the number to be placed
+ */
+static void rate_place (
+  struct srate *rs,
+  unsigned idx,
+  unsigned num
+) {
+  assert(rs != 0);
+  const sud_mask bit = (sud_mask) 1 << num;
+  if (!(rs->cans[idx] & bit)) {
+    /* taken or no candidate anymore */
+    rs->dead = true;
+    return;
+  }
+  const unsigned row = IDX_ROW(idx);
+  const unsigned col = IDX_COL(idx);
+  const unsigned grp = IDX_GRP(idx);
+  for (unsigned pos = 0; pos < SSIZE; ++pos) {
+    rs->cans[unit_slot(row, pos)] &= ~bit;
+    rs->cans[unit_slot(SSIZE + col, pos)] &= ~bit;
+    rs->cans[unit_slot(SSIZE * 2 + grp, pos)] &= ~bit;
+  }
+  rs->grid[idx] = num;
+  rs->cans[idx] = 0;
+  rs->left -= 1;
+}
+
+/**
+ * eliminates candidates of a slot
+ *
+ * @param  rs  the logic state
+ * @param  idx the index in the grid
+ * @param  msk the candidates to be eliminated
+ * @return     true if a candidate was eliminated
+ */
+static inline bool rate_elim (
+  struct srate *rs,
+  unsigned idx,
+  sud_mask msk
+) {
+  if (!(rs->cans[idx] & msk)) {
+    return false;
+  }
+  rs->cans[idx] &= ~msk;
+  if (rs->cans[idx] == 0) {
+    /* an empty slot without candidates */
+    rs->dead = true;
+  }
+  return true;
+}
+
+/**
+ * returns the positions of a number in a unit
+ *
+ * @param  rs  the logic state
+ * @param  unt the unit: rows first, then columns, then groups
+ * @param  num the number
+ * @return     bit per position
+ */
+static inline uint32_t rate_where (
+  const struct srate *rs,
+  unsigned unt,
+  unsigned num
+) {
+  uint32_t res = 0;
+  for (unsigned pos = 0; pos < SSIZE; ++pos) {
+    if (rs->cans[unit_slot(unt, pos)] & ((sud_mask) 1 << num)) {
+      res |= (uint32_t) 1 << pos;
+    }
+  }
+  return res;
+}
+
+/**
+ * places naked singles, slots with one candidate
+ *
+ * @param  rs the logic state
+ * @param  n  unused
+ * @return    true if a number was placed
+ */
+static bool rate_naked1 (
+  struct srate *rs,
+  unsigned n
+) {
+  (void) n;
+  bool res = false;
+  for (unsigned idx = 0; idx < SCELLS && !rs->dead; ++idx) {
+    if (rs->grid[idx] == 0 && __builtin_popcount(rs->cans[idx]) <= 1) {
+      if (rs->cans[idx] == 0) {
+        rs->dead = true;
+        return true;
+      }
+      rate_place(rs, idx, __builtin_ctz(rs->cans[idx]));
+      res = true;
+    }
+  }
+  return res;
+}
+
+/**
+ * places hidden singles, numbers with one slot in a unit
+ *
+ * @param  rs the logic state
+ * @param  n  unused
+ * @return    true if a number was placed
+ */
+static bool rate_hidden1 (
+  struct srate *rs,
+  unsigned n
+) {
+  (void) n;
+  bool res = false;
+  for (unsigned unt = 0; unt < SSIZE * 3 && !rs->dead; ++unt) {
+    sud_mask seen = 0;
+    sud_mask once = 0;
+    sud_mask more = 0;
+    for (unsigned pos = 0; pos < SSIZE; ++pos) {
+      const unsigned idx = unit_slot(unt, pos);
+      seen |= (sud_mask) 1 << rs->grid[idx];
+      more |= once & rs->cans[idx];
+      once |= rs->cans[idx];
+    }
+    if (((seen | once) & ALLCANDS) != ALLCANDS) {
+      /* a number has no slot left */
+      rs->dead = true;
+      return true;
+    }
+    sud_mask hid = once & ~more;
+    while (hid) {
+      const unsigned num = __builtin_ctz(hid);
+      hid &= hid - 1;
+      const uint32_t pos = rate_where(rs, unt, num);
+      if (pos == 0) {
+        /* placed by a single before */
+        rs->dead = true;
+        return true;
+      }
+      rate_place(rs, unit_slot(unt, __builtin_ctz(pos)), num);
+      res = true;
+    }
+  }
+  return res;
+}
+
+/**
+ * eliminates locked candidates: a number of a group that is
+ * confined to one row or column (pointing) and a number of a
+ * row or column that is confined to one group (claiming)
+ *
+ * @param  rs the logic state
+ * @param  n  unused
+ * @return    true if a candidate was eliminated
+ */
+static bool rate_locked (
+  struct srate *rs,
+  unsigned n
+) {
+  (void) n;
+  /* positions of the first line of a group and of a line segment */
+  const uint32_t line = ((uint32_t) 1 << SBOX) - 1;
+  uint32_t cross = 0;
+  for (unsigned k = 0; k < SBOX; ++k) {
+    cross |= (uint32_t) 1 << (k * SBOX);
+  }
+  bool res = false;
+  for (unsigned num = 1; num <= SSIZE; ++num) {
+    const sud_mask bit = (sud_mask) 1 << num;
+    for (unsigned grp = 0; grp < SSIZE; ++grp) {
+      const uint32_t pos = rate_where(rs, SSIZE * 2 + grp, num);
+      if (pos == 0) {
+        continue;
+      }
+      const unsigned frst = unit_slot(SSIZE * 2 + grp, __builtin_ctz(pos));
+      for (unsigned k = 0; k < SBOX; ++k) {
+        if ((pos & ~(line << (k * SBOX))) == 0) {
+          /* pointing, one row */
+          for (unsigned p = 0; p < SSIZE; ++p) {
+            const unsigned idx = unit_slot(IDX_ROW(frst), p);
+            if (IDX_GRP(idx) != grp) {
+              res |= rate_elim(rs, idx, bit);
+            }
+          }
+        }
+        if ((pos & ~(cross << k)) == 0) {
+          /* pointing, one column */
+          for (unsigned p = 0; p < SSIZE; ++p) {
+            const unsigned idx = unit_slot(SSIZE + IDX_COL(frst), p);
+            if (IDX_GRP(idx) != grp) {
+              res |= rate_elim(rs, idx, bit);
+            }
+          }
+        }
+      }
+    }
+    for (unsigned unt = 0; unt < SSIZE * 2; ++unt) {
+      const uint32_t pos = rate_where(rs, unt, num);
+      if (pos == 0) {
+        continue;
+      }
+      for (unsigned k = 0; k < SBOX; ++k) {
+        if ((pos & ~(line << (k * SBOX))) != 0) {
+          continue;
+        }
+        /* claiming, one group */
+        const unsigned grp = IDX_GRP(unit_slot(unt, __builtin_ctz(pos)));
+        for (unsigned p = 0; p < SSIZE; ++p) {
+          const unsigned idx = unit_slot(SSIZE * 2 + grp, p);
+          const bool same = unt < SSIZE
+            ? IDX_ROW(idx) == unt
+            : IDX_COL(idx) == unt - SSIZE;
+          if (!same) {
+            res |= rate_elim(rs, idx, bit);
+          }
+        }
+      }
+    }
+  }
+  return res;
+}
+
+/**
+ * picks `cb->n` of the masks (each with 1 to n bits) whose union
+ * has n bits and passes them to `cb->apply`, until it succeeds
+ *
+ * @param  cb   the masks and the action
+ * @param  from first mask to pick
+ * @param  cnt  masks picked so far
+ * @param  pick the picked masks, bit per index
+ * @param  uni  union of the picked masks
+ * @return      true if a set was applied
+ */
+static bool rate_combo (
+  struct scombo *cb,
+  unsigned from,
+  unsigned cnt,
+  uint32_t pick,
+  uint32_t uni
+) {
+  if (cnt == cb->n) {
+    return cb->apply(cb, pick, uni);
+  }
+  for (unsigned i = from; i + (cb->n - cnt) <= SSIZE; ++i) {
+    const uint32_t msk = cb->msk[i];
+    if (msk == 0 || (unsigned) __builtin_popcount(uni | msk) > cb->n) {
+      continue;
+    }
+    if (rate_combo(cb, i + 1, cnt + 1, pick | (uint32_t) 1 << i, uni | msk)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * naked subset: the candidates of the picked slots are
+ * removed from the other slots of the unit
+ */
+static bool rate_naked_apply (
+  struct scombo *cb,
+  uint32_t pick,
+  uint32_t uni
+) {
+  bool res = false;
+  for (unsigned pos = 0; pos < SSIZE; ++pos) {
+    if (!(pick & ((uint32_t) 1 << pos))) {
+      res |= rate_elim(cb->rs, unit_slot(cb->arg, pos), uni);
+    }
+  }
+  return res;
+}
+
+/**
+ * hidden subset: the picked numbers take all candidates
+ * of their slots
+ */
+static bool rate_hidden_apply (
+  struct scombo *cb,
+  uint32_t pick,
+  uint32_t uni
+) {
+  bool res = false;
+  for (unsigned pos = 0; pos < SSIZE; ++pos) {
+    if (uni & ((uint32_t) 1 << pos)) {
+      res |= rate_elim(cb->rs, unit_slot(cb->arg, pos), ~(pick << 1));
+    }
+  }
+  return res;
+}
+
+/**
+ * fish: the number is removed from the cross lines
+ * outside of the picked base lines
+ */
+static bool rate_fish_apply (
+  struct scombo *cb,
+  uint32_t pick,
+  uint32_t uni
+) {
+  /* base lines are rows for `arg` up to SSIZE, then columns */
+  const bool rows = cb->arg <= SSIZE;
+  const unsigned num = rows ? cb->arg : cb->arg - SSIZE;
+  bool res = false;
+  for (unsigned crs = 0; crs < SSIZE; ++crs) {
+    if (!(uni & ((uint32_t) 1 << crs))) {
+      continue;
+    }
+    for (unsigned pos = 0; pos < SSIZE; ++pos) {
+      if (!(pick & ((uint32_t) 1 << pos))) {
+        const unsigned idx = rows ? pos * SSIZE + crs : crs * SSIZE + pos;
+        res |= rate_elim(cb->rs, idx, (sud_mask) 1 << num);
+      }
+    }
+  }
+  return res;
+}
+
+/**
+ * naked subsets of n slots
+ *
+ * @param  rs the logic state
+ * @param  n  the size of the subset
+ * @return    true if a candidate was eliminated
+ */
+static bool rate_naked (
+  struct srate *rs,
+  unsigned n
+) {
+  struct scombo cb = { .rs = rs, .n = n, .apply = rate_naked_apply };
+  for (unsigned unt = 0; unt < SSIZE * 3; ++unt) {
+    for (unsigned pos = 0; pos < SSIZE; ++pos) {
+      cb.msk[pos] = rs->cans[unit_slot(unt, pos)];
+    }
+    cb.arg = unt;
+    if (rate_combo(&cb, 0, 0, 0, 0)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * hidden subsets of n numbers
+ *
+ * @param  rs the logic state
+ * @param  n  the size of the subset
+ * @return    true if a candidate was eliminated
+ */
+static bool rate_hidden (
+  struct srate *rs,
+  unsigned n
+) {
+  struct scombo cb = { .rs = rs, .n = n, .apply = rate_hidden_apply };
+  for (unsigned unt = 0; unt < SSIZE * 3; ++unt) {
+    for (unsigned num = 1; num <= SSIZE; ++num) {
+      cb.msk[num - 1] = rate_where(rs, unt, num);
+    }
+    cb.arg = unt;
+    if (rate_combo(&cb, 0, 0, 0, 0)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * fish with n rows or columns (x-wing, swordfish, jellyfish)
+ *
+ * @param  rs the logic state
+ * @param  n  the number of base lines
+ * @return    true if a candidate was eliminated
+ */
+static bool rate_fish (
+  struct srate *rs,
+  unsigned n
+) {
+  struct scombo cb = { .rs = rs, .n = n, .apply = rate_fish_apply };
+  for (unsigned num = 1; num <= SSIZE; ++num) {
+    for (unsigned unt = 0; unt < SSIZE * 2; unt += SSIZE) {
+      for (unsigned lin = 0; lin < SSIZE; ++lin) {
+        cb.msk[lin] = rate_where(rs, unt + lin, num);
+      }
+      cb.arg = unt + num;
+      if (rate_combo(&cb, 0, 0, 0, 0)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/**
+ * techniques of the rating, easiest first, scores as
+ * in sudoku explainer
+ */
+static const struct {
+  enum sud_tech tech;
+  bool (*fn)(struct srate *rs, unsigned n);
+  unsigned n;
+  double score;
+} rate_techs[] = {
+  { SUD_TECH_HIDDEN1, rate_hidden1, 1, 1.5 },
+  { SUD_TECH_NAKED1, rate_naked1, 1, 2.3 },
+  { SUD_TECH_LOCKED, rate_locked, 1, 2.6 },
+  { SUD_TECH_NAKED2, rate_naked, 2, 3.0 },
+  { SUD_TECH_XWING, rate_fish, 2, 3.2 },
+  { SUD_TECH_HIDDEN2, rate_hidden, 2, 3.4 },
+  { SUD_TECH_NAKED3, rate_naked, 3, 3.6 },
+  { SUD_TECH_SWORDFISH, rate_fish, 3, 3.8 },
+  { SUD_TECH_HIDDEN3, rate_hidden, 3, 4.0 },
+  { SUD_TECH_NAKED4, rate_naked, 4, 5.0 },
+  { SUD_TECH_JELLYFISH, rate_fish, 4, 5.2 },
+  { SUD_TECH_HIDDEN4, rate_hidden, 4, 5.4 }
+};
+
+/* number of techniques */
+#define STECHS (sizeof(rate_techs) / sizeof(rate_techs[0]))
+
+/* score of a puzzle that needs a search, without its nodes */
+#define SSEARCH 6.0
+
+/**
+ * returns the binary logarithm of a positive number,
+ * linear between powers of 2
+ *
+ * @param  num the number
+ * @return     the logarithm
+ */
+static double rate_log2 (
+  unsigned long num
+) {
+  assert(num > 0);
+  const unsigned exp = sizeof(num) * 8 - 1 - __builtin_clzl(num);
+  const unsigned long pow = 1ul << exp;
+  return exp + (double) (num - pow) / pow;
+}
+
+int sud_rate (
+  struct sud_ctx *ctx,
+  const sud_cell grid[],
+  struct sud_rating *rt
+) {
+  assert(ctx != 0);
+  assert(grid != 0);
+  assert(rt != 0);
+  const int err = check_grid(ctx, grid);
+  if (err != SUD_OK) {
+    return err;
+  }
+  rt->score = 0;
+  rt->tech = SUD_TECH_NONE;
+  rt->steps = 0;
+  rt->nodes = 0;
+  ctx->nodes = 0;
+
+  /* candidates of the givens */
+  struct srate rs;
+  memset(rs.grid, 0, sizeof(rs.grid));
+  for (unsigned idx = 0; idx < SCELLS; ++idx) {
+    rs.cans[idx] = ALLCANDS;
+  }
+  rs.left = SCELLS;
+  rs.dead = false;
+  for (unsigned idx = 0; idx < SCELLS; ++idx) {
+    if (grid[idx]) {
+      rate_place(&rs, idx, grid[idx]);
+    }
+  }
+
+  /* the easiest technique that makes progress, again and again */
+  while (rs.left > 0 && !rs.dead) {
+    unsigned ti = 0;
+    while (ti < STECHS && !rate_techs[ti].fn(&rs, rate_techs[ti].n)) {
+      ti += 1;
+    }
+    if (ti == STECHS) {
+      /* stuck */
+      break;
+    }
+    rt->steps += 1;
+    if (rate_techs[ti].tech > rt->tech) {
+      rt->tech = rate_techs[ti].tech;
+      rt->score = rate_techs[ti].score;
+    }
+  }
+  if (rs.left == 0 && !rs.dead) {
+    return SUD_OK;
+  }
+
+  /* stuck or a contradiction, the effort of a single-threaded
+    search tells the rest (and if there is a solution at all) */
+  #if defined(SSTATS)
+    sstats = &ctx->stats;
+  #endif
+  STATS_ROOT();
+  struct spool *pl = &ctx->pool;
+  budget_start(pl, &ctx->conf);
+  init_state(&ctx->st, grid);
+  pl->limit = 1;
+  atomic_store(&pl->count, 0);
+  const unsigned long base = snodes;
+  const bool res = find_solution_st(pl, pl->size, &ctx->st);
+  ctx->nodes = snodes - base;
+  rt->nodes = ctx->nodes;
+  if (!res) {
+    return atomic_load(&pl->spent) ? SUD_LIMIT : SUD_NOSOL;
+  }
+  rt->tech = SUD_TECH_SEARCH;
+  rt->score = SSEARCH + rate_log2(rt->nodes);
+  return SUD_OK;
+}
+
+#if defined(SSTATS)
+/**
+ * adds the statistics of a thread
+ *
+ * @param sum the sum
+ * @param add the statistics to be added
+ */
+static void stats_add (
+  struct sstats *sum,
+  const struct sstats *add
+) {
+  assert(sum != 0);
+  assert(add != 0);
+  sum->nodes += add->nodes;
+  sum->tries += add->tries;
+  sum->backs += add->backs;
+  sum->slot += add->slot;
+  if (add->maxdep > sum->maxdep) {
+    sum->maxdep = add->maxdep;
+  }
+  for (unsigned dep = 0; dep <= SCELLS; ++dep) {
+    for (unsigned cnt = 0; cnt <= SSIZE; ++cnt) {
+      sum->branch[dep][cnt] += add->branch[dep][cnt];
+    }
+  }
+}
+
+/**
+ * prints one line of statistics
+ *
+ * @param out  output-file
+ * @param name name of the line
+ * @param st   the statistics
+ */
+static void stats_line (
+  FILE *out,
+  const char *name,
+  const struct sstats *st
+) {
+  fprintf(out, "%-10s %14lu %14lu %14lu %6u %12.3f\n",
+    name, st->nodes, st->tries, st->backs,
+    st->maxdep, st->slot / 1e6);
+}
+#endif
+
+void sud_stats (
+  const struct sud_ctx *ctx,
+  FILE *out,
+  double wall
+) {
+  assert(ctx != 0);
+  assert(out != 0);
+  #if defined(SSTATS)
+    const struct spool *pl = &ctx->pool;
+    struct sstats *sum = calloc(1, sizeof(*sum));
+    if (!sum) {
+      fputs("unable to allocate statistics\n", out);
+      return;
+    }
+    fprintf(out, "\n%-10s %14s %14s %14s %6s %12s\n",
+      "thread", "nodes", "tries", "backtracks", "depth", "slot [ms]");
+    stats_line(out, "main", &ctx->stats);
+    stats_add(sum, &ctx->stats);
+    for (unsigned pi = 0; pi < pl->size; ++pi) {
+      char name[24];
+      snprintf(name, sizeof(name), "worker %u", pi);
+      stats_line(out, name, &pl->stats[pi]);
+      stats_add(sum, &pl->stats[pi]);
+    }
+    stats_line(out, "total", sum);
+    fprintf(out, "\nwall %.3f ms, find_slot %.3f ms (%.1f%% of all threads)\n",
+      wall / 1e3, sum->slot / 1e6,
+      wall > 0 ? sum->slot / 1e1 / wall / (pl->size ? pl->size : 1) : 0);
+    /* branching factor histogram */
+    fputs("\nbranching factor per depth:\ndepth", out);
+    for (unsigned cnt = 0; cnt <= SSIZE; ++cnt) {
+      fprintf(out, " %10u", cnt);
+    }
+    fputs("\n", out);
+    for (unsigned dep = 0; dep <= SCELLS; ++dep) {
+      unsigned long any = 0;
+      for (unsigned cnt = 0; cnt <= SSIZE; ++cnt) {
+        any |= sum->branch[dep][cnt];
+      }
+      if (!any) {
+        continue;
+      }
+      fprintf(out, "%5u", dep);
+      for (unsigned cnt = 0; cnt <= SSIZE; ++cnt) {
+        fprintf(out, " %10lu", sum->branch[dep][cnt]);
+      }
+      fputs("\n", out);
+    }
+    free(sum);
+  #else
+    (void) ctx;
+    (void) wall;
+    fputs("statistics are not compiled in (build with -DSSTATS)\n", out);
+  #endif
+}
+
+/**
+ * state of the generator, shared by all threads
+ */
+struct sgen {
+  const struct sud_gen *conf;
+  struct sud_ctx *ctx;
+  /* index of the next puzzle */
+  atomic_ulong next;
+  /* true if the generators should give up */
+  atomic_bool stop;
+  /* protects the callback, the result, the window and the statistics */
+  pthread_mutex_t mtx;
+  /* signaled when the window moved on */
+  pthread_cond_t room;
+  /* puzzles done ahead of `emitted`, slot index % `ahead` */
+  sud_cell (*ring)[SCELLS];
+  bool *full;
+  unsigned ahead;
+  /* index of the next puzzle to emit, the puzzles are
+    emitted in index order whatever thread made them */
+  unsigned long emitted;
+  /* first failure */
+  int res;
+  /* cpu per generator, 0 if they are not pinned */
+  const unsigned *cpus;
+  /* index of the next generator that starts */
+  atomic_uint seat;
+};
+
+/**
+ * `sud_enum` callback of the uniqueness check
+ *
+ * @param  grid the solution
+ * @param  arg  the enumeration
+ * @return      false from the second solution on
+ */
+static bool gen_solution (
+  const sud_cell grid[],
+  void *arg
+) {
+  (void) grid;
+  const struct sud_enum *en = arg;
+  return en->count < 2;
+}
+
+/**
+ * checks if a puzzle has exactly one solution
+ *
+ * @param  st   the search state
+ * @param  grid the sudoku grid
+ * @return      true if the solution is unique
+ */
+static bool gen_unique (
+  struct sstate *st,
+  const sud_cell grid[]
+) {
+  assert(st != 0);
+  assert(grid != 0);
+  struct sud_enum en;
+  en.emit = gen_solution;
+  en.arg = &en;
+  en.len = SUD_NOCURSOR;
+  en.count = 0;
+  enum_solutions(st, grid, &en);
+  return en.count == 1;
+}
+
+/**
+ * returns the slots that map onto each other under a symmetry
+ *
+ * @param  idx  a slot
+ * @param  sym  the symmetry
+ * @param  res  the slots (output, at most 4)
+ * @return      number of slots, 0 if idx is not the first one
+ */
+static unsigned gen_orbit (
+  unsigned idx,
+  enum sud_sym sym,
+  unsigned res[4]
+) {
+  assert(res != 0);
+  const unsigned row = IDX_ROW(idx);
+  const unsigned col = IDX_COL(idx);
+  const unsigned end = SSIZE - 1;
+  unsigned len = 0;
+  res[len++] = idx;
+  switch (sym) {
+    case SUD_SYM_NONE:
+      break;
+    case SUD_SYM_ROT2:
+      res[len++] = (end - row) * SSIZE + (end - col);
+      break;
+    case SUD_SYM_ROT4:
+      res[len++] = col * SSIZE + (end - row);
+      res[len++] = (end - row) * SSIZE + (end - col);
+      res[len++] = (end - col) * SSIZE + row;
+      break;
+    case SUD_SYM_MIRROR:
+      res[len++] = row * SSIZE + (end - col);
+      break;
+    case SUD_SYM_DIAG:
+      res[len++] = col * SSIZE + row;
+      break;
+  }
+  /* drop duplicates (center, diagonal), the first slot wins */
+  unsigned num = 1;
+  for (unsigned i = 1; i < len; ++i) {
+    if (res[i] < idx) {
+      /* handled with another slot */
+      return 0;
+    }
+    bool dup = false;
+    for (unsigned j = 0; j < num; ++j) {
+      dup |= res[j] == res[i];
+    }
+    if (!dup) {
+      res[num++] = res[i];
+    }
+  }
+  return num;
+}
+
+/**
+ * generates a puzzle with a unique solution. clues are removed
+ * in random order as long as the solution stays unique
+ *
+ * @param  st   the search state
+ * @param  grid the puzzle (output)
+ * @param  conf the batch (clues and symmetry)
+ * @param  rng  the generator state
+ * @return      false if the target clue count was not reached
+ */
+static bool gen_puzzle (
+  struct sstate *st,
+  sud_cell grid[],
+  const struct sud_gen *conf,
+  uint64_t *rng
+) {
+  assert(st != 0);
+  assert(grid != 0);
+  assert(conf != 0);
+  assert(rng != 0);
+  for (unsigned tries = 0; tries < SGENTRIES; ++tries) {
+    /* random filled grid */
+    memset(grid, 0, sizeof(sud_cell) * SCELLS);
+    init_state(st, grid);
+    if (!fill_grid_st(st, rng)) {
+      /* an empty grid always has a solution */
+      return false;
+    }
+    memcpy(grid, st->grid, sizeof(st->grid));
+
+    /* slots in random order */
+    unsigned order[SCELLS];
+    for (unsigned i = 0; i < SCELLS; ++i) {
+      order[i] = i;
+    }
+    for (unsigned i = SCELLS; i > 1; --i) {
+      const unsigned j = rng_next(rng) % i;
+      const unsigned tmp = order[i - 1];
+      order[i - 1] = order[j];
+      order[j] = tmp;
+    }
+
+    unsigned clues = SCELLS;
+    for (unsigned i = 0; i < SCELLS && clues > conf->clues; ++i) {
+      unsigned slots[4];
+      const unsigned len = gen_orbit(order[i], conf->sym, slots);
+      if (len == 0 || clues - len < conf->clues) {
+        /* not the first slot of its orbit or too many clues */
+        continue;
+      }
+      unsigned nums[4];
+      for (unsigned j = 0; j < len; ++j) {
+        nums[j] = grid[slots[j]];
+        grid[slots[j]] = 0;
+      }
+      if (gen_unique(st, grid)) {
+        clues -= len;
+        continue;
+      }
+      /* put them back */
+      for (unsigned j = 0; j < len; ++j) {
+        grid[slots[j]] = nums[j];
+      }
+    }
+
+    if (clues <= conf->clues || conf->clues == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * records the first failure of the generator and
+ * lets all threads give up
+ *
+ * @param gen the generator, locked by the caller
+ * @param res the status code
+ */
+static void gen_fail (
+  struct sgen *gen,
+  int res
+) {
+  assert(gen != 0);
+  if (gen->res == SUD_OK) {
+    gen->res = res;
+  }
+  atomic_store(&gen->stop, true);
+  /* nobody waits for the window any more */
+  pthread_cond_broadcast(&gen->room);
+}
+
+/**
+ * stores a puzzle in the window and emits all puzzles that are
+ * next in index order, must be called with the mutex held
+ *
+ * @param gen  the generator
+ * @param num  index of the puzzle
+ * @param grid the puzzle
+ */
+static void gen_emit (
+  struct sgen *gen,
+  unsigned long num,
+  const sud_cell grid[]
+) {
+  assert(gen != 0);
+  assert(num - gen->emitted < gen->ahead);
+  const struct sud_gen *conf = gen->conf;
+  memcpy(gen->ring[num % gen->ahead], grid, SCELLS);
+  gen->full[num % gen->ahead] = true;
+  while (gen->full[gen->emitted % gen->ahead]) {
+    const unsigned slot = gen->emitted % gen->ahead;
+    gen->full[slot] = false;
+    gen->emitted += 1;
+    if (!atomic_load(&gen->stop) && !conf->emit(gen->ring[slot], conf->arg)) {
+      gen_fail(gen, SUD_STOP);
+    }
+  }
+  pthread_cond_broadcast(&gen->room);
+}
+
+/**
+ * callback for pthread, generates puzzles until all are done
+ *
+ * @param pass the generator
+ */
+static void * gen_worker (void *pass)
+{
+  struct sgen *gen = pass;
+  const struct sud_gen *conf = gen->conf;
+  struct sstate st;
+  if (gen->cpus) {
+    /* the state lives on the stack of the pinned thread */
+    sud_pin(gen->cpus[atomic_fetch_add(&gen->seat, 1)]);
+  }
+  #if defined(SSTATS)
+    /* added to the context when done */
+    struct sstats *own = calloc(1, sizeof(*own));
+    if (!own) {
+      pthread_mutex_lock(&gen->mtx);
+      gen_fail(gen, SUD_ENOMEM);
+      pthread_mutex_unlock(&gen->mtx);
+      return 0;
+    }
+    sstats = own;
+  #endif
+
+  while (!atomic_load(&gen->stop)) {
+    const unsigned long num = atomic_fetch_add(&gen->next, 1);
+    if (num >= conf->count) {
+      break;
+    }
+    /* the generator of the next puzzle to emit never waits */
+    pthread_mutex_lock(&gen->mtx);
+    while (!atomic_load(&gen->stop) && num - gen->emitted >= gen->ahead) {
+      pthread_cond_wait(&gen->room, &gen->mtx);
+    }
+    pthread_mutex_unlock(&gen->mtx);
+    /* one generator per puzzle, the same seed gives the same puzzles */
+    uint64_t rng = conf->seed ^ (num * 0xD1B54A32D192ED03);
+    sud_cell grid[SCELLS];
+    const bool res = gen_puzzle(&st, grid, conf, &rng);
+
+    pthread_mutex_lock(&gen->mtx);
+    if (!res) {
+      gen_fail(gen, SUD_EGEN);
+    } else if (!atomic_load(&gen->stop)) {
+      gen_emit(gen, num, grid);
+    }
+    pthread_mutex_unlock(&gen->mtx);
+  }
+
+  #if defined(SSTATS)
+    pthread_mutex_lock(&gen->mtx);
+    stats_add(&gen->ctx->stats, own);
+    pthread_mutex_unlock(&gen->mtx);
+    sstats = &gen->ctx->stats;
+    free(own);
+  #endif
+  return 0;
+}
+
+int sud_generate (
+  struct sud_ctx *ctx,
+  const struct sud_gen *conf
+) {
+  assert(ctx != 0);
+  assert(conf != 0);
+  if (!conf->emit || conf->clues > SCELLS || conf->sym > SUD_SYM_DIAG) {
+    whops(ctx, SUD_EINVAL, "invalid generator");
+  }
+
+  struct sgen gen;
+  gen.conf = conf;
+  gen.ctx = ctx;
+  gen.res = SUD_OK;
+  gen.cpus = 0;
+  gen.emitted = 0;
+  atomic_init(&gen.next, 0);
+  atomic_init(&gen.stop, false);
+  atomic_init(&gen.seat, 0);
+
+  unsigned size = conf->jobs;
+  if (size == 0) {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    size = ncpu > 0 ? ncpu : 1;
+  }
+
+  /* the generators are placed like the workers */
+  unsigned *cpus = 0;
+  if (ctx->conf.place.bind != SUD_BIND_NONE && size > 1) {
+    cpus = calloc(size, sizeof(unsigned));
+    if (!cpus) {
+      whops(ctx, SUD_ENOMEM, "unable to allocate %u generators", size);
+    }
+    const int err = sud_place_cpus(&ctx->conf.place, size, cpus, 0);
+    if (err != SUD_OK) {
+      free(cpus);
+      whops(ctx, err, "unable to place %u generators", size);
+    }
+    gen.cpus = cpus;
+  }
+  gen.ahead = SGENAHEAD * size;
+  gen.ring = calloc(gen.ahead, sizeof(*gen.ring));
+  gen.full = calloc(gen.ahead, sizeof(bool));
+  if (!gen.ring || !gen.full) {
+    free(gen.ring);
+    free(gen.full);
+    free(cpus);
+    whops(ctx, SUD_ENOMEM, "unable to allocate %u generators", size);
+  }
+  pthread_mutex_init(&gen.mtx, 0);
+  pthread_cond_init(&gen.room, 0);
+
+  if (size == 1) {
+    /* the calling thread is enough */
+    gen_worker(&gen);
+  } else {
+    pthread_t *thrd = calloc(size, sizeof(pthread_t));
+    if (!thrd) {
+      pthread_cond_destroy(&gen.room);
+      pthread_mutex_destroy(&gen.mtx);
+      free(gen.ring);
+      free(gen.full);
+      free(cpus);
+      whops(ctx, SUD_ENOMEM, "unable to allocate %u generators", size);
+    }
+    unsigned ti = 0;
+    while (ti < size) {
+      if (pthread_create(&thrd[ti], 0, gen_worker, &gen)) {
+        pthread_mutex_lock(&gen.mtx);
+        gen_fail(&gen, SUD_ETHREAD);
+        pthread_mutex_unlock(&gen.mtx);
+        break;
+      }
+      ti += 1;
+    }
+    /* only the started generators are joined */
+    while (ti > 0) {
+      pthread_join(thrd[--ti], 0);
+    }
+    free(thrd);
+  }
+  free(cpus);
+
+  pthread_cond_destroy(&gen.room);
+  pthread_mutex_destroy(&gen.mtx);
+  free(gen.ring);
+  free(gen.full);
+  ctx->nodes = 0;
+  switch (gen.res) {
+    case SUD_EGEN:
+      whops(ctx, SUD_EGEN,
+        "unable to generate a puzzle with %u clues", conf->clues);
+    case SUD_ENOMEM:
+      whops(ctx, SUD_ENOMEM, "unable to allocate a generator");
+    case SUD_ETHREAD:
+      whops(ctx, SUD_ETHREAD, "unable to start a generator");
+  }
+  return gen.res;
+}
+
+#if defined(__linux__)
+/**
+ * a cpu of the placement
+ */
+struct scpu {
+  unsigned cpu;
+  /* numa node and physical core (package << 16 | core) */
+  unsigned node;
+  unsigned core;
+  /* hardware thread of the core, 0 for the first one */
+  unsigned smt;
+  /* position in its node, in compact order */
+  unsigned rank;
+};
+
+/**
+ * reads a number of the sysfs topology of a cpu
+ *
+ * @param  cpu  the cpu
+ * @param  name the file in the topology directory
+ * @param  def  the default if there is no such file
+ * @return      the number
+ */
+static unsigned topo_number (
+  unsigned cpu,
+  const char *name,
+  unsigned def
+) {
+  char path[96];
+  snprintf(path, sizeof(path),
+    "/sys/devices/system/cpu/cpu%u/topology/%s", cpu, name);
+  FILE *inp = fopen(path, "r");
+  if (!inp) {
+    return def;
+  }
+  unsigned res;
+  if (fscanf(inp, "%u", &res) != 1) {
+    res = def;
+  }
+  fclose(inp);
+  return res;
+}
+
+/**
+ * returns the numa node of a cpu, its sysfs directory
+ * has a link to the node
+ *
+ * @param  cpu the cpu
+ * @return     the node, 0 without numa
+ */
+static unsigned topo_node (
+  unsigned cpu
+) {
+  char path[64];
+  snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u", cpu);
+  DIR *dir = opendir(path);
+  if (!dir) {
+    return 0;
+  }
+  unsigned res = 0;
+  const struct dirent *ent;
+  while ((ent = readdir(dir))) {
+    if (sscanf(ent->d_name, "node%u", &res) == 1) {
+      break;
+    }
+  }
+  closedir(dir);
+  return res;
+}
+
+/**
+ * compares two cpus in compact order: by node, the first
+ * thread of every core before the second one, then by core
+ *
+ * @param  a
+ * @param  b
+ * @return   <0, 0 or >0
+ */
+static int topo_compact (
+  const void *a,
+  const void *b
+) {
+  const struct scpu *x = a;
+  const struct scpu *y = b;
+  if (x->node != y->node) {
+    return x->node < y->node ? -1 : 1;
+  }
+  if (x->smt != y->smt) {
+    return x->smt < y->smt ? -1 : 1;
+  }
+  if (x->core != y->core) {
+    return x->core < y->core ? -1 : 1;
+  }
+  return (x->cpu > y->cpu) - (x->cpu < y->cpu);
+}
+
+/**
+ * compares two cpus in scatter order: the nodes take turns
+ *
+ * @param  a
+ * @param  b
+ * @return   <0, 0 or >0
+ */
+static int topo_scatter (
+  const void *a,
+  const void *b
+) {
+  const struct scpu *x = a;
+  const struct scpu *y = b;
+  if (x->rank != y->rank) {
+    return x->rank < y->rank ? -1 : 1;
+  }
+  return (x->node > y->node) - (x->node < y->node);
+}
+
+/**
+ * returns the cpus the process may run on with their
+ * topology, in compact order
+ *
+ * @param  len number of cpus (output)
+ * @return     the cpus or 0 if out of memory
+ */
+static struct scpu * topo_read (
+  unsigned *len
+) {
+  assert(len != 0);
+  cpu_set_t set;
+  if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+    return 0;
+  }
+  struct scpu *cpus = calloc(CPU_COUNT(&set), sizeof(*cpus));
+  if (!cpus) {
+    return 0;
+  }
+  unsigned num = 0;
+  for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (!CPU_ISSET(cpu, &set)) {
+      continue;
+    }
+    struct scpu *sc = &cpus[num++];
+    sc->cpu = cpu;
+    sc->node = topo_node(cpu);
+    sc->core =
+      topo_number(cpu, "physical_package_id", 0) << 16 |
+      topo_number(cpu, "core_id", cpu);
+    /* siblings with a lower number come first */
+    sc->smt = 0;
+    for (unsigned oth = 0; oth + 1 < num; ++oth) {
+      sc->smt += cpus[oth].core == sc->core;
+    }
+  }
+  qsort(cpus, num, sizeof(*cpus), topo_compact);
+  for (unsigned idx = 0, rank = 0; idx < num; ++idx) {
+    rank = idx > 0 && cpus[idx - 1].node == cpus[idx].node ? rank + 1 : 0;
+    cpus[idx].rank = rank;
+  }
+  *len = num;
+  return cpus;
+}
+#endif
+
+int sud_place_cpus (
+  const struct sud_place *place,
+  unsigned size,
+  unsigned cpus[],
+  unsigned nodes[]
+) {
+  assert(place != 0);
+  assert(cpus != 0 || size == 0);
+  #if defined(__linux__)
+    if (place->bind == SUD_BIND_NONE || place->bind > SUD_BIND_LIST) {
+      return SUD_EINVAL;
+    }
+    unsigned len;
+    struct scpu *topo = topo_read(&len);
+    if (!topo) {
+      return SUD_ENOMEM;
+    }
+    if (place->bind == SUD_BIND_SCATTER) {
+      qsort(topo, len, sizeof(*topo), topo_scatter);
+    }
+    for (unsigned wi = 0; wi < size; ++wi) {
+      const struct scpu *sc = &topo[wi % len];
+      if (place->bind == SUD_BIND_LIST) {
+        /* only cpus the process may run on */
+        const unsigned cpu = place->cpus[wi % place->ncpus];
+        unsigned idx = 0;
+        while (idx < len && topo[idx].cpu != cpu) {
+          idx += 1;
+        }
+        if (idx == len) {
+          free(topo);
+          return SUD_EINVAL;
+        }
+        sc = &topo[idx];
+      }
+      cpus[wi] = sc->cpu;
+      if (nodes) {
+        nodes[wi] = sc->node;
+      }
+    }
+    free(topo);
+    return SUD_OK;
+  #else
+    (void) size;
+    (void) cpus;
+    (void) nodes;
+    return SUD_EINVAL;
+  #endif
+}
+
+int sud_pin (
+  unsigned cpu
+) {
+  #if defined(__linux__)
+    if (cpu >= CPU_SETSIZE) {
+      return SUD_EINVAL;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+      return SUD_EINVAL;
+    }
+    return SUD_OK;
+  #else
+    (void) cpu;
+    return SUD_EINVAL;
+  #endif
+}
+
+/* kernels per instruction set, in the order of `enum sud_isa` */
+static const struct skern skerns[] = {
+  [SUD_ISA_GENERIC] = {
+    propagate_generic, find_slot_generic, classify_cells, check_cells
+  },
+#if defined(SDISPATCH) && SBOX == 3
+  [SUD_ISA_SSE4] = {
+    propagate_popcnt, find_slot_sse4, classify_cells_sse2, check_cells
+  },
+  [SUD_ISA_AVX2] = {
+    propagate_avx2, find_slot_avx2, classify_cells_avx2, check_cells_avx2
+  }
+#elif defined(SDISPATCH)
+  /* the vector kernels are 9*9 only */
+  [SUD_ISA_SSE4] = {
+    propagate_popcnt, find_slot_popcnt, classify_cells, check_cells
+  },
+  [SUD_ISA_AVX2] = {
+    propagate_avx2, find_slot_popcnt, classify_cells, check_cells
+  }
+#endif
+};
+
+/* the kernels are chosen once */
+static pthread_once_t skern_once = PTHREAD_ONCE_INIT;
+
+/**
+ * returns the best instruction set of the cpu
+ *
+ * @return the instruction set
+ */
+static enum sud_isa kern_best ()
+{
+  #if defined(SDISPATCH)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") &&
+        __builtin_cpu_supports("bmi") &&
+        __builtin_cpu_supports("popcnt")) {
+      return SUD_ISA_AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1") &&
+        __builtin_cpu_supports("popcnt")) {
+      return SUD_ISA_SSE4;
+    }
+  #endif
+  return SUD_ISA_GENERIC;
+}
+
+/**
+ * chooses the kernels of the cpu, called once
+ */
+static void kern_init ()
+{
+  skern_isa = kern_best();
+  skern = skerns[skern_isa];
+}
+
+int sud_isa_select (
+  enum sud_isa isa
+) {
+  pthread_once(&skern_once, kern_init);
+  const enum sud_isa best = kern_best();
+  if (isa == SUD_ISA_AUTO) {
+    isa = best;
+  }
+  /* every level includes the ones below */
+  if (isa < SUD_ISA_GENERIC || isa > best) {
+    return SUD_EINVAL;
+  }
+  skern_isa = isa;
+  skern = skerns[isa];
+  return SUD_OK;
+}
+
+enum sud_isa sud_isa_active ()
+{
+  pthread_once(&skern_once, kern_init);
+  return skern_isa;
+}
+
+int sud_open (
+  struct sud_ctx **res,
+  const struct sud_conf *conf
+) {
+  assert(res != 0);
+  assert(conf != 0);
+  *res = 0;
+  if (conf->engine != SUD_MASK && conf->engine != SUD_DLX &&
+      (conf->engine != SUD_BITS || SBOX != 3)) {
+    return SUD_EINVAL;
+  }
+  if ((unsigned) conf->heur >= sizeof(sheurs) / sizeof(*sheurs)) {
+    return SUD_EINVAL;
+  }
+  if (conf->place.bind > SUD_BIND_LIST ||
+      (conf->place.bind == SUD_BIND_LIST && conf->place.ncpus == 0)) {
+    return SUD_EINVAL;
+  }
+  pthread_once(&skern_once, kern_init);
+
+  /* the search state is aligned to a cache line */
+  struct sud_ctx *ctx = aligned_alloc(SLINE, sizeof(*ctx));
+  if (!ctx) {
+    return SUD_ENOMEM;
+  }
+  memset(ctx, 0, sizeof(*ctx));
+  ctx->conf = *conf;
+  ctx->pool.heur = conf->heur;
+
+  if (conf->cache) {
+    /* two levels of the canonical search */
+    ctx->canon = malloc(2 * SCANMAX * sizeof(*ctx->canon));
+    if (!ctx->canon) {
+      free(ctx);
+      return SUD_ENOMEM;
+    }
+  }
+
+  if (conf->threads && conf->engine == SUD_MASK) {
+    /* workers are reused for every call */
+    const int err = start_pool(&ctx->pool, conf->jobs, &conf->place);
+    if (err != SUD_OK) {
+      free(ctx->canon);
+      free(ctx);
+      return err;
+    }
+  }
+
+  *res = ctx;
+  return SUD_OK;
+}
+
+void sud_close (
+  struct sud_ctx *ctx
+) {
+  if (!ctx) {
+    return;
+  }
+  stop_pool(&ctx->pool);
+  free(ctx->canon);
+  free(ctx);
+}
+
+int sud_cache_open (
+  struct sud_cache **res,
+  unsigned long size
+) {
+  assert(res != 0);
+  *res = 0;
+  if (size == 0 || size >= NOENTRY) {
+    return SUD_EINVAL;
+  }
+  struct sud_cache *cache = calloc(1, sizeof(*cache));
+  if (!cache) {
+    return SUD_ENOMEM;
+  }
+  /* about two buckets per entry */
+  unsigned long heads = 1;
+  while (heads < 2 * size) {
+    heads *= 2;
+  }
+  cache->ents = malloc(size * sizeof(*cache->ents));
+  cache->heads = malloc(heads * sizeof(*cache->heads));
+  if (!cache->ents || !cache->heads) {
+    free(cache->ents);
+    free(cache->heads);
+    free(cache);
+    return SUD_ENOMEM;
+  }
+  memset(cache->heads, 0xFF, heads * sizeof(*cache->heads));
+  cache->size = size;
+  cache->mask = heads - 1;
+  pthread_mutex_init(&cache->mtx, 0);
+  *res = cache;
+  return SUD_OK;
+}
+
+void sud_cache_close (
+  struct sud_cache *cache
+) {
+  if (!cache) {
+    return;
+  }
+  pthread_mutex_destroy(&cache->mtx);
+  free(cache->ents);
+  free(cache->heads);
+  free(cache);
+}
+
+void sud_cache_info (
+  struct sud_cache *cache,
+  struct sud_cache_info *info
+) {
+  assert(cache != 0);
+  assert(info != 0);
+  pthread_mutex_lock(&cache->mtx);
+  info->size = cache->size;
+  info->entries = cache->len;
+  info->hits = cache->hits;
+  info->misses = cache->misses;
+  info->bypass = cache->bypass;
+  info->evicted = cache->evicted;
+  pthread_mutex_unlock(&cache->mtx);
+}
+
+unsigned long sud_nodes (
+  const struct sud_ctx *ctx
+) {
+  assert(ctx != 0);
+  return ctx->nodes;
+}
+
+const char * sud_message (
+  const struct sud_ctx *ctx
+) {
+  assert(ctx != 0);
+  return ctx->msg[0] ? ctx->msg : "no error";
+}
+
+const char * sud_tech_name (
+  enum sud_tech tech
+) {
+  switch (tech) {
+    case SUD_TECH_NONE:
+      return "none";
+    case SUD_TECH_HIDDEN1:
+      return "hidden-single";
+    case SUD_TECH_NAKED1:
+      return "naked-single";
+    case SUD_TECH_LOCKED:
+      return "locked-candidates";
+    case SUD_TECH_NAKED2:
+      return "naked-pair";
+    case SUD_TECH_XWING:
+      return "x-wing";
+    case SUD_TECH_HIDDEN2:
+      return "hidden-pair";
+    case SUD_TECH_NAKED3:
+      return "naked-triple";
+    case SUD_TECH_SWORDFISH:
+      return "swordfish";
+    case SUD_TECH_HIDDEN3:
+      return "hidden-triple";
+    case SUD_TECH_NAKED4:
+      return "naked-quad";
+    case SUD_TECH_JELLYFISH:
+      return "jellyfish";
+    case SUD_TECH_HIDDEN4:
+      return "hidden-quad";
+    case SUD_TECH_SEARCH:
+      return "search";
+  }
+  return "unknown";
+}
+
+const char * sud_heur_name (
+  enum sud_heur heur
+) {
+  switch (heur) {
+    case SUD_HEUR_MRV:
+      return "mrv";
+    case SUD_HEUR_UNIT:
+      return "unit";
+    case SUD_HEUR_LCV:
+      return "lcv";
+  }
+  return "unknown";
+}
+
+const char * sud_isa_name (
+  enum sud_isa isa
+) {
+  switch (isa) {
+    case SUD_ISA_AUTO:
+      return "auto";
+    case SUD_ISA_GENERIC:
+      return "generic";
+    case SUD_ISA_SSE4:
+      return "sse4";
+    case SUD_ISA_AVX2:
+      return "avx2";
+  }
+  return "unknown";
+}
+
+const char * sud_strerror (
+  int res
+) {
+  switch (res) {
+    case SUD_OK:
+      return "success";
+    case SUD_NOSOL:
+      return "no solution";
+    case SUD_MORE:
+      return "premature end of input";
+    case SUD_STOP:
+      return "stopped by the callback";
+    case SUD_LIMIT:
+      return "gave up, out of budget";
+    case SUD_ESYNTAX:
+      return "invalid input";
+    case SUD_EDUP:
+      return "duplicate value";
+    case SUD_EINVAL:
+      return "invalid argument";
+    case SUD_ENOMEM:
+      return "out of memory";
+    case SUD_ETHREAD:
+      return "unable to start a thread";
+    case SUD_EGEN:
+      return "unable to generate a puzzle";
+  }
+  return "unknown error";
+}
@@ -0,0 +1,620 @@
+/**
+ * To the extent possible under law, the author(s) have dedicated
+ * all copyright and related and neighboring rights to this software
+ * to the public domain worldwide. This software is distributed
+ * without any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ *
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/**
+ * libsudoku, the solver of `swip` and `ssud` as a library
+ *
+ * all state lives in a context, nothing is global but the
+ * kernels of the cpu (see `sud_isa_select`) and no function
+ * exits the process. a context must not be used by two
+ * threads at once, different contexts are independent.
+ * the library and its users must be built with the same SBOX
+ */
+
+#ifndef SUDOKU_H
+#define SUDOKU_H
+
+#include <stdbool.h> /* bool */
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* uint8_t, uint64_t */
+#include <stdio.h> /* FILE */
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/* box size, build with -DSBOX=4 for 16*16 or -DSBOX=5 for 25*25 */
+#if !defined(SBOX)
+  #define SBOX 3
+#endif
+
+#if SBOX < 2 || SBOX > 5
+  #error "SBOX must be between 2 and 5"
+#endif
+
+/* numbers per row, column and group */
+#define SSIZE (SBOX*SBOX)
+/* slots in the grid */
+#define SCELLS (SSIZE*SSIZE)
+
+/* symbols of the numbers 1 to SSIZE, hex for 16*16 */
+#if SSIZE == 16
+  #define SSYMBOLS "0123456789ABCDEF"
+#else
+  #define SSYMBOLS "123456789ABCDEFGHIJKLMNOP"
+#endif
+
+/* a slot of the grid, 0 for empty */
+typedef uint8_t sud_cell;
+
+/**
+ * status codes, all functions returning `int` use them
+ */
+enum sud_status {
+  /* success */
+  SUD_OK,
+  /* the puzzle has no solution */
+  SUD_NOSOL,
+  /* the input ends inside a grid */
+  SUD_MORE,
+  /* the enumeration was stopped by its callback */
+  SUD_STOP,
+  /* the search gave up, a budget of the context ran out */
+  SUD_LIMIT,
+  /* invalid symbol or layout */
+  SUD_ESYNTAX,
+  /* a number is given twice in a row, column or group */
+  SUD_EDUP,
+  /* invalid argument or engine */
+  SUD_EINVAL,
+  /* out of memory */
+  SUD_ENOMEM,
+  /* unable to start a thread */
+  SUD_ETHREAD,
+  /* the generator gave up */
+  SUD_EGEN
+};
+
+/**
+ * solver engines
+ */
+enum sud_engine {
+  /* bitmask backtracking */
+  SUD_MASK,
+  /* dancing links */
+  SUD_DLX,
+  /* per-digit bitboards (9*9 only) */
+  SUD_BITS
+};
+
+/**
+ * symmetries of generated puzzles
+ */
+enum sud_sym {
+  /* no symmetry */
+  SUD_SYM_NONE,
+  /* 180 degree rotation */
+  SUD_SYM_ROT2,
+  /* 90 degree rotation */
+  SUD_SYM_ROT4,
+  /* left-right mirror */
+  SUD_SYM_MIRROR,
+  /* main diagonal */
+  SUD_SYM_DIAG
+};
+
+/**
+ * branching heuristics of the bitmask engine
+ */
+enum sud_heur {
+  /* the slot with the fewest candidates, lowest number first */
+  SUD_HEUR_MRV,
+  /* like MRV, ties go to the slot in the fullest unit */
+  SUD_HEUR_UNIT,
+  /* like MRV, the least constraining number first */
+  SUD_HEUR_LCV
+};
+
+/**
+ * instruction sets of the kernels (propagation, slot choice,
+ * parsing and validation), each one includes the ones above
+ */
+enum sud_isa {
+  /* the best one of the cpu */
+  SUD_ISA_AUTO,
+  /* plain C */
+  SUD_ISA_GENERIC,
+  /* sse4.1 and popcnt */
+  SUD_ISA_SSE4,
+  /* avx2, bmi and popcnt */
+  SUD_ISA_AVX2
+};
+
+/**
+ * placement policies of threads (linux only)
+ */
+enum sud_bind {
+  /* left to the scheduler */
+  SUD_BIND_NONE,
+  /* the cores of a numa node before the next node */
+  SUD_BIND_COMPACT,
+  /* the numa nodes take turns */
+  SUD_BIND_SCATTER,
+  /* the cpus of a list, in order */
+  SUD_BIND_LIST
+};
+
+/**
+ * a placement of threads on cpus. both policies use the cores
+ * of the process before their second hardware threads
+ */
+struct sud_place {
+  /* the policy */
+  enum sud_bind bind;
+  /* the cpus of SUD_BIND_LIST, thread n runs on cpus[n % ncpus] */
+  const unsigned *cpus;
+  unsigned ncpus;
+};
+
+/**
+ * solving techniques of the rating, easiest first
+ */
+enum sud_tech {
+  /* nothing to do, the grid is full */
+  SUD_TECH_NONE,
+  /* a number fits in one slot of a unit */
+  SUD_TECH_HIDDEN1,
+  /* a slot has one candidate */
+  SUD_TECH_NAKED1,
+  /* pointing and claiming */
+  SUD_TECH_LOCKED,
+  /* n slots of a unit share n candidates */
+  SUD_TECH_NAKED2,
+  /* fish with 2 lines */
+  SUD_TECH_XWING,
+  /* n numbers of a unit share n slots */
+  SUD_TECH_HIDDEN2,
+  SUD_TECH_NAKED3,
+  /* fish with 3 lines */
+  SUD_TECH_SWORDFISH,
+  SUD_TECH_HIDDEN3,
+  SUD_TECH_NAKED4,
+  /* fish with 4 lines */
+  SUD_TECH_JELLYFISH,
+  SUD_TECH_HIDDEN4,
+  /* the techniques got stuck, the puzzle needs a search */
+  SUD_TECH_SEARCH
+};
+
+/**
+ * difficulty of a puzzle
+ */
+struct sud_rating {
+  /* the score, from 1.5 (hidden singles) to 5.4 (hidden quads)
+    for puzzles that need no search, 6 plus the binary logarithm
+    of the search nodes for those that do */
+  double score;
+  /* the hardest technique needed */
+  enum sud_tech tech;
+  /* number of technique steps */
+  unsigned long steps;
+  /* search nodes, 0 without search */
+  unsigned long nodes;
+};
+
+/* opaque result cache */
+struct sud_cache;
+
+/**
+ * configuration of a context, all zero is a
+ * single-threaded bitmask solver
+ */
+struct sud_conf {
+  /* solver engine */
+  enum sud_engine engine;
+  /* solve on a worker pool (bitmask engine only) */
+  bool threads;
+  /* number of workers, 0 for one per cpu */
+  unsigned jobs;
+  /* result cache of `sud_solve`, 0 for none */
+  struct sud_cache *cache;
+  /* search nodes per `sud_solve` or `sud_count` before
+    giving up, 0 for no limit */
+  unsigned long budget;
+  /* wall time per `sud_solve` or `sud_count` in microseconds
+    before giving up, 0 for no limit */
+  unsigned long timeout;
+  /* branching heuristic (bitmask engine only) */
+  enum sud_heur heur;
+  /* placement of the workers and generators, each one pins
+    itself before it allocates its memory, so the memory is
+    on its numa node. the list must outlive the context */
+  struct sud_place place;
+};
+
+/**
+ * counters of a result cache
+ */
+struct sud_cache_info {
+  /* capacity and used entries */
+  unsigned long size;
+  unsigned long entries;
+  /* lookups with and without a result */
+  unsigned long hits;
+  unsigned long misses;
+  /* puzzles solved without the cache (no canonical form) */
+  unsigned long bypass;
+  /* entries replaced by newer ones */
+  unsigned long evicted;
+};
+
+/**
+ * a solution enumeration. the cursor (the numbers taken at
+ * each branch up to the last solution) survives the call,
+ * so an enumeration can be resumed later on
+ */
+struct sud_enum {
+  /* called for each solution, returns false to stop */
+  bool (*emit)(const sud_cell grid[], void *arg);
+  /* passed to `emit` */
+  void *arg;
+  /* numbers taken per branch depth, the cursor */
+  uint8_t path[SCELLS];
+  /* length of the cursor, SUD_NOCURSOR to start over */
+  unsigned len;
+  /* emitted solutions */
+  unsigned long count;
+  /* used by the search */
+  unsigned replay;
+  bool skip;
+};
+
+/* cursor length of a new enumeration */
+#define SUD_NOCURSOR (SCELLS+1)
+
+/**
+ * a batch of generated puzzles
+ */
+struct sud_gen {
+  /* number of puzzles */
+  unsigned long count;
+  /* target clue count, 0 for as few as possible */
+  unsigned clues;
+  /* symmetry of the clues */
+  enum sud_sym sym;
+  /* the same seed gives the same puzzles */
+  uint64_t seed;
+  /* generator threads, 0 for one per cpu */
+  unsigned jobs;
+  /* called for each puzzle (one at a time, in the same order for
+    any number of threads), returns false to stop */
+  bool (*emit)(const sud_cell grid[], void *arg);
+  /* passed to `emit` */
+  void *arg;
+};
+
+/* opaque solver context */
+struct sud_ctx;
+
+/**
+ * creates a context, the memory of the search and the
+ * worker pool are allocated once and reused by every call
+ *
+ * @param  ctx  the context (output)
+ * @param  conf the configuration
+ * @return      SUD_OK, SUD_EINVAL, SUD_ENOMEM or SUD_ETHREAD
+ */
+int sud_open (
+  struct sud_ctx **ctx,
+  const struct sud_conf *conf
+);
+
+/**
+ * forces the kernels of an instruction set for all contexts
+ * of the process, e.g. for benchmarks. by default the best
+ * one of the cpu is chosen when the first context is opened.
+ * must not be called while a context is in use
+ *
+ * @param  isa the instruction set, SUD_ISA_AUTO for the best one
+ * @return     SUD_OK or SUD_EINVAL if the cpu does not support it
+ */
+int sud_isa_select (
+  enum sud_isa isa
+);
+
+/**
+ * returns the cpus of a placement for a number of threads,
+ * the same for every call
+ *
+ * @param  place the placement, not SUD_BIND_NONE
+ * @param  size  number of threads
+ * @param  cpus  cpu per thread (output)
+ * @param  nodes numa node per thread (output), may be 0
+ * @return       SUD_OK, SUD_ENOMEM or SUD_EINVAL if a cpu of the
+ *               list is not available (or not on linux)
+ */
+int sud_place_cpus (
+  const struct sud_place *place,
+  unsigned size,
+  unsigned cpus[],
+  unsigned nodes[]
+);
+
+/**
+ * pins the calling thread to a cpu
+ *
+ * @param  cpu the cpu
+ * @return     SUD_OK or SUD_EINVAL
+ */
+int sud_pin (
+  unsigned cpu
+);
+
+/**
+ * returns the instruction set of the kernels in use
+ *
+ * @return the instruction set, never SUD_ISA_AUTO
+ */
+enum sud_isa sud_isa_active ();
+
+/**
+ * stops the workers and frees the context
+ *
+ * @param ctx the context, may be 0
+ */
+void sud_close (
+  struct sud_ctx *ctx
+);
+
+/**
+ * parses the next grid of a text buffer. a grid is either
+ * SSIZE lines with SSIZE symbols each or a single line with
+ * SCELLS symbols, a space, "." or "0" (except for 16*16) is
+ * a empty slot. lines end with "\n", "\r\n" or the end of the
+ * buffer, empty lines are skipped. single line grids are
+ * parsed in place, the buffer may be a file mapping
+ *
+ * @param  ctx  the context
+ * @param  grid the grid (output)
+ * @param  buf  the buffer
+ * @param  len  length of the buffer
+ * @param  used consumed bytes (output), on SUD_MORE the
+ *              empty lines that can be dropped
+ * @return      SUD_OK, SUD_MORE, SUD_ESYNTAX or SUD_EDUP
+ */
+int sud_parse (
+  struct sud_ctx *ctx,
+  sud_cell grid[],
+  const char *buf,
+  size_t len,
+  size_t *used
+);
+
+/**
+ * solves a puzzle with the engine of the context. the budgets
+ * of the context are checked every few search nodes, a search
+ * that runs out of them gives up with SUD_LIMIT (`sud_nodes`
+ * tells how far it got)
+ *
+ * @param  ctx  the context
+ * @param  grid the grid, solved on success
+ * @return      SUD_OK, SUD_NOSOL, SUD_LIMIT, SUD_ESYNTAX or SUD_EDUP
+ */
+int sud_solve (
+  struct sud_ctx *ctx,
+  sud_cell grid[]
+);
+
+/**
+ * counts the solutions of a puzzle (bitmask engine only),
+ * a limit of 2 is enough to check if the solution is unique.
+ * on SUD_LIMIT the count is the number found so far
+ *
+ * @param  ctx   the context
+ * @param  grid  the grid, not modified
+ * @param  limit stop counting at this many solutions
+ * @param  cnt   number of solutions (output), at most `limit`
+ * @return       SUD_OK, SUD_LIMIT, SUD_EINVAL, SUD_ESYNTAX or SUD_EDUP
+ */
+int sud_count (
+  struct sud_ctx *ctx,
+  const sud_cell grid[],
+  unsigned long limit,
+  unsigned long *cnt
+);
+
+/**
+ * rates the difficulty of a puzzle. the techniques are applied
+ * easiest first until the grid is full, if they get stuck the
+ * puzzle is solved with the bitmask engine (single-threaded,
+ * within the budgets) and its search nodes are rated instead.
+ * the solution is not checked for uniqueness
+ *
+ * @param  ctx  the context
+ * @param  grid the grid, not modified
+ * @param  rt   the rating (output)
+ * @return      SUD_OK, SUD_NOSOL, SUD_LIMIT, SUD_ESYNTAX or SUD_EDUP
+ */
+int sud_rate (
+  struct sud_ctx *ctx,
+  const sud_cell grid[],
+  struct sud_rating *rt
+);
+
+/**
+ * enumerates the solutions of a puzzle (bitmask engine only,
+ * single-threaded). each solution is passed to the callback in
+ * search order. an enumeration stopped by its callback continues
+ * after the last emitted solution when it is passed in again
+ *
+ * @param  ctx  the context
+ * @param  grid the grid, not modified
+ * @param  en   the enumeration
+ * @return      SUD_OK if done, SUD_STOP, SUD_EINVAL,
+ *              SUD_ESYNTAX or SUD_EDUP
+ */
+int sud_enum (
+  struct sud_ctx *ctx,
+  const sud_cell grid[],
+  struct sud_enum *en
+);
+
+/**
+ * generates puzzles with a unique solution, on its
+ * own threads (the worker pool is not used)
+ *
+ * @param  ctx the context
+ * @param  gen the batch
+ * @return     SUD_OK, SUD_STOP, SUD_EGEN, SUD_ENOMEM or SUD_ETHREAD
+ */
+int sud_generate (
+  struct sud_ctx *ctx,
+  const struct sud_gen *gen
+);
+
+/**
+ * creates a result cache. `sud_solve` of every context with
+ * the cache looks up puzzles by their canonical form, the same
+ * puzzle after swapping rows, columns, bands or stacks, turning
+ * it over the diagonal or renumbering is a hit (only rows and
+ * bands for grids larger than 9*9). a puzzle with more than
+ * one solution may get another one of them from the cache.
+ * the cache is thread-safe and must outlive its contexts
+ *
+ * @param  cache the cache (output)
+ * @param  size  the number of entries
+ * @return       SUD_OK, SUD_EINVAL or SUD_ENOMEM
+ */
+int sud_cache_open (
+  struct sud_cache **cache,
+  unsigned long size
+);
+
+/**
+ * frees a result cache
+ *
+ * @param cache the cache, may be 0
+ */
+void sud_cache_close (
+  struct sud_cache *cache
+);
+
+/**
+ * reads the counters of a result cache
+ *
+ * @param cache the cache
+ * @param info  the counters (output)
+ */
+void sud_cache_info (
+  struct sud_cache *cache,
+  struct sud_cache_info *info
+);
+
+/**
+ * returns the search nodes of the last call
+ *
+ * @param  ctx the context
+ * @return     the nodes
+ */
+unsigned long sud_nodes (
+  const struct sud_ctx *ctx
+);
+
+/**
+ * prints the search statistics of all calls, only
+ * available when the library is built with -DSSTATS
+ *
+ * @param ctx  the context
+ * @param out  output-file
+ * @param wall wall time of the calls in microseconds
+ */
+void sud_stats (
+  const struct sud_ctx *ctx,
+  FILE *out,
+  double wall
+);
+
+/**
+ * returns the message of the last error of a context
+ *
+ * @param  ctx the context
+ * @return     the message
+ */
+const char * sud_message (
+  const struct sud_ctx *ctx
+);
+
+/**
+ * returns a short description of a status code
+ *
+ * @param  res the status code
+ * @return     the description
+ */
+const char * sud_strerror (
+  int res
+);
+
+/**
+ * returns the name of a technique, e.g. "x-wing"
+ *
+ * @param  tech the technique
+ * @return      the name
+ */
+const char * sud_tech_name (
+  enum sud_tech tech
+);
+
+/**
+ * returns the name of a branching heuristic, e.g. "lcv"
+ *
+ * @param  heur the heuristic
+ * @return      the name
+ */
+const char * sud_heur_name (
+  enum sud_heur heur
+);
+
+/**
+ * returns the name of an instruction set, e.g. "avx2"
+ *
+ * @param  isa the instruction set
+ * @return     the name
+ */
+const char * sud_isa_name (
+  enum sud_isa isa
+);
+
+/**
+ * returns the number of a symbol
+ *
+ * @param  chr the symbol (letters are case insensitive)
+ * @return     the number or 0 if the symbol is invalid
+ */
+unsigned sud_value (
+  char chr
+);
+
+/**
+ * returns the symbol of a number
+ *
+ * @param  num the number, 0 for a empty slot
+ * @return     the symbol
+ */
+char sud_symbol (
+  unsigned num
+);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
@@ -1,4 +1,3 @@
-
 /** 
  * To the extent possible under law, the author(s) have dedicated 
  * all copyright and related and neighboring rights to this software
@@ -11,27 +10,42 @@
  * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
  */
 
+#if defined(__linux__)
+  /* CPU_SETSIZE */
+  #define _GNU_SOURCE
+#endif
+
 #include <stdlib.h> /* exit, malloc, free */
 #include <stdio.h> /* stdin, feof, fgetc */
-#include <stdint.h> /* uint32_t */
+#include <stdint.h> /* uint64_t */
 #include <stdbool.h> /* bool, true false */
 #include <string.h> /* memcpy */
-#include <pthread.h> /* pthread ... */
 #include <assert.h> /* assert */
-#include <unistd.h> /* usleep */
-
-/* used to indicate that "no index" was found */
-#define NOINDEX (9*9)+1
+#include <time.h> /* clock_gettime */
+#include <limits.h> /* ULONG_MAX */
+#include <unistd.h> /* lseek, read, write, close, sysconf */
+#include <sys/stat.h> /* fstat, lstat */
+#include <sys/mman.h> /* mmap, munmap, posix_madvise */
+#include <pthread.h> /* pthread ... */
+#include <stdatomic.h> /* atomic_uint */
 
-/* used to indicate that no candidates where found */
-/* this is a bitmask with bit 0 to 9 set to 1 */
-#define NOCANDS 0x3FF
+#if defined(__linux__)
+  #include <errno.h> /* errno */
+  #include <signal.h> /* sigaction, pthread_sigmask */
+  #include <fcntl.h> /* fcntl */
+  #include <sys/socket.h> /* socket, bind, listen, accept */
+  #include <sys/un.h> /* sockaddr_un */
+  #include <sys/epoll.h> /* epoll_create1, epoll_ctl, epoll_pwait */
+  #include <sys/eventfd.h> /* eventfd */
+  #include <sched.h> /* CPU_SETSIZE */
+#endif
 
-#define SRUNNING 1
-#define SFAILURE 2
-#define SSUCCESS 3
+#if !defined(CPU_SETSIZE)
+  /* placements are only supported on linux, see `sud_place_cpus` */
+  #define CPU_SETSIZE 1024
+#endif
 
-typedef uint32_t sud_mask;
+#include "sudoku.h"
 
 /**
  * program options
@@ -39,12 +53,65 @@ typedef uint32_t sud_mask;
 struct sopts {
   /* use threads */
   bool threads;
+  /* number of worker threads, 0 for one per cpu */
+  unsigned jobs;
+  /* solver engine */
+  enum sud_engine engine;
+  /* branching heuristic, or all of them (benchmark mode) */
+  enum sud_heur heur;
+  bool heurs;
+  /* instruction set of the kernels */
+  enum sud_isa isa;
+  /* placement of the threads and their cpus, 0 if not pinned */
+  struct sud_place place;
+  unsigned *cpus;
   /* use fancy output-format */
   bool fancy;
   /* show help */
   bool help;
+  /* batch mode */
+  bool batch;
+  /* print search statistics */
+  bool verbose;
+  /* count solutions instead of printing one */
+  bool count;
+  /* stop counting at this many solutions */
+  unsigned long limit;
+  /* stream solutions */
+  bool stream;
+  /* stop streaming after this many solutions */
+  unsigned long max;
+  /* resume streaming after this cursor */
+  const char *cursor;
+  /* number of puzzles to generate */
+  unsigned long gen;
+  /* target clue count, 0 for as few as possible */
+  unsigned clues;
+  /* symmetry of generated puzzles */
+  enum sud_sym sym;
+  /* seed of the generator */
+  uint64_t seed;
+  /* benchmark mode */
+  bool bench;
+  /* benchmark runs and warmup runs per grid */
+  unsigned reps;
+  unsigned warm;
+  /* benchmark csv output file */
+  const char *csv;
+  /* grid files (benchmark mode) */
+  char **files;
+  unsigned nfiles;
   /* test mode (uses a "hard" grid) */
   bool test;
+  /* daemon socket, "-" for stdin and stdout */
+  const char *daemon;
+  /* result cache entries, 0 for none */
+  unsigned long cache;
+  /* search nodes and microseconds per puzzle, 0 for no limit */
+  unsigned long budget;
+  unsigned long timeout;
+  /* rate the difficulty instead of solving */
+  bool rate;
 };
 
 /**
@@ -57,363 +124,107 @@ struct sopts {
 } while (0)
 
 /**
- * calculates a score based on seen numbers
- * in the given row and column (and group)
+ * sudoku solver entrypoint
  *
+ * @param  ctx  the solver
  * @param  grid the sudoku grid
- * @param  row  the row
- * @param  col  column
- * @return      the score
+ * @return      SUD_OK, SUD_NOSOL or SUD_LIMIT (out of budget)
  */
-static sud_mask find_cans (
-  unsigned grid[],
-  unsigned idx,
-  unsigned *len
+static int solve_puzzle (
+  struct sud_ctx *ctx,
+  sud_cell grid[]
 ) {
+  assert(ctx != 0);
   assert(grid != 0);
-  sud_mask res = 0;
-  sud_mask msk = 0;
-  /* calculate region */
-  const unsigned row = idx / 9;
-  const unsigned col = idx % 9;
-  const unsigned rx = row / 3 * 3;
-  const unsigned ry = col / 3 * 3;
-  for (unsigned i = 0; i < 9; ++i) {
-    unsigned rnm = grid[(row * 9) + i];
-    unsigned cnm = grid[col + (i * 9)];
-
-    /* 9 by 9 region */
-    unsigned reg = 
-      (rx + (i / 3)) * 9 + 
-      (ry + (i % 3));
-
-    unsigned gnm = grid[reg];
-
-    msk |= (1 << rnm);
-    msk |= (1 << cnm);
-    msk |= (1 << gnm);
-  }
-  res = ~msk & 0x0000FFFF;
-  if (len) {
-    *len = 10;
-    /* count bits */
-    while (msk > 0) {
-      if (msk & 1) {
-        assert(*len > 0);
-        *len -= 1;
-      }
-      msk >>= 1;
-    }
+  const int res = sud_solve(ctx, grid);
+  if (res != SUD_OK && res != SUD_NOSOL && res != SUD_LIMIT) {
+    whops("%s", sud_message(ctx));
   }
   return res;
 }
 
 /**
- * returns a index in the grid with the least possibilities
- *
- * @param  grid the sudoku grid
- * @param  out  candidate bitmask output
- * @return      the index or NOINDEX if no index was found
- */
-static unsigned find_slot (
-  unsigned grid[],
-  sud_mask *slot
-) {
-  assert(grid != 0);
-  assert(slot != 0);
-  unsigned idx = NOINDEX;
-  sud_mask prv = 0;
-  sud_mask res = 0;
-  /* check each index and fill-in
-    obvious candidates */
-  for (unsigned i = 0; i < (9*9); ++i) {
-    if (grid[i] == 0) {
-      /* empty slot */
-      unsigned len = 0;
-      sud_mask msk;
-      msk = find_cans(grid, i, &len);
-      if (prv == 0 || len < prv) {
-        /* better candidate */
-        prv = len;
-        res = msk;
-        idx = i;
-        if (len <= 1) {
-          /* best possible result */
-          break;
-        }
-      }
-    }
-  }
-  /* check if we found something */
-  if (prv > 0 && slot) {
-    /* assign values to slot */
-    *slot = res;
-  }
-  return idx;
-}
-
-/**
- * tries to find a solution for the given puzzle.
- * nothing fancy, just a simple/stupid xxx (badword on github!)
+ * counts the solutions of a puzzle up to `opts->limit`
  *
- * single threaded
- *
- * @param  grid the sudoku grid
- * @param  idx  the index in the grid to be checked
- * @return      true if a solution was found, false otherwise
+ * @param  ctx  the solver
+ * @param  grid the sudoku grid, not modified
+ * @param  opts program options
+ * @param  cnt  number of solutions (output), at most `opts->limit`
+ * @return      SUD_OK or SUD_LIMIT (out of budget)
  */
-static bool find_solution_st (
-  unsigned grid[]
+static int count_solutions (
+  struct sud_ctx *ctx,
+  const sud_cell grid[],
+  const struct sopts *opts,
+  unsigned long *cnt
 ) {
-  assert(grid != 0);
-  unsigned idx;
-
-  /* candidates */
-  sud_mask can = 0;
-  idx = find_slot(grid, &can);
-
-  if (idx == NOINDEX) {
-    /* no empty slot found */
-    return true;
-  }
-
-  if (can == NOCANDS) {
-    /* no candidates */
-    return false;
-  }
-
-  #define UNROLLED_CHECK(num)           \
-    if (can & (1 << num)) {        \
-      grid[idx] = num;                  \
-      if (find_solution_st(grid)) {     \
-        return true;                    \
-      }                                 \
-      grid[idx] = 0;                    \
-    }
-
-  UNROLLED_CHECK(1);
-  UNROLLED_CHECK(2);
-  UNROLLED_CHECK(3);
-  UNROLLED_CHECK(4);
-  UNROLLED_CHECK(5);
-  UNROLLED_CHECK(6);
-  UNROLLED_CHECK(7);
-  UNROLLED_CHECK(8);
-  UNROLLED_CHECK(9);
-
-  /* no solution found */
-  return false;
-}
-
-/**
- * callback for pthread
- *
- * @param slot
- */
-static void * find_solution_th (void *pass) 
-{
-  assert(pass != 0);
-  unsigned *smem = pass;
-  unsigned *stat = smem; /* status slot */
-  unsigned *grid = smem + 1;
-  *stat = SRUNNING;
-  /* set cancel state */
-  pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, 0);
-  /* use the single-thread solver */
-  if (find_solution_st(grid)) {
-    /* solution was found */
-    *stat = SSUCCESS;
-  } else {
-    *stat = SFAILURE;
+  assert(ctx != 0);
+  assert(opts != 0);
+  const int res = sud_count(ctx, grid, opts->limit, cnt);
+  if (res != SUD_OK && res != SUD_LIMIT) {
+    whops("%s", sud_message(ctx));
   }
-  /* get out */
-  return 0;
+  return res;
 }
 
 /**
- * starts the single-threaded solver in a thread
+ * prints the line of a puzzle that ran out of budget
  *
- * @param pt   the thread handle
- * @param grid the grid memory for this thread
- * @param smem the memory slot for this thread
- * @param idx  the index in the grid we're at
- * @param num  the number to be tested
- * @return     the memory slot
+ * @param ctx the solver
+ * @param out output-file
  */
-static void solve_fork (
-  pthread_t *const pt,
-  unsigned grid[],
-  unsigned *smem,
-  unsigned idx,
-  unsigned num
+static void print_gaveup (
+  const struct sud_ctx *ctx,
+  FILE *out
 ) {
-  assert(grid != 0);
-  assert(smem != 0);
-  /* first slot is for the success/failure status */
-  memcpy(smem + 1, grid, sizeof(unsigned)*9*9);
-  /* fill in the number to test */
-  smem[idx + 1] = num;
-  /* fork off! */
-  pthread_create(pt, 0, find_solution_th, smem);
+  assert(out != 0);
+  fprintf(out, "gave up after %lu nodes\n", sud_nodes(ctx));
 }
 
 /**
- * joins the given thread back
+ * prints a solution count, "+" marks a reached limit
  *
- * @param  pt   the pthread handle
- * @param  pi   thread id
- * @param  grid the grid memory
- * @param  copy true if the result should be copied
- * @param  tmem  the thread memory
- * @return      true if a solution was found
+ * @param cnt  the number of solutions
+ * @param opts program options
+ * @param out  output-file
  */
-static bool solve_join (
-  pthread_t *const pt,
-  const unsigned pi,
-  unsigned grid[],
-  bool *const sfnd,
-  const unsigned *const tmem
+static void print_count (
+  unsigned long cnt,
+  const struct sopts *opts,
+  FILE *out
 ) {
-  assert(pt != 0);
-  assert(grid != 0);
-  assert(tmem != 0);
-
-  /* unsigned int should be atomic, but just to be safe */
-  static pthread_mutex_t mtx =
-    PTHREAD_MUTEX_INITIALIZER;
-
-  if (*sfnd) {
-    /* thread no longer needed */
-    pthread_cancel(*pt);
-    pthread_join(*pt, 0);
-    return true;
-  }
-
-  /* check thread status */
-  pthread_mutex_lock(&mtx);
-
-  if (*tmem == SRUNNING) {
-    /* thread is still running */
-    pthread_mutex_unlock(&mtx);
-    return false;
-  }
-
-  pthread_join(*pt, 0);
-  
-  if (!*sfnd) {
-    if (*tmem == SSUCCESS) {
-      /* copy solution */
-      memcpy(grid, tmem + 1, sizeof(unsigned)*9*9);
-      *sfnd = true;
-    }
-  }
-
-  pthread_mutex_unlock(&mtx);
-  return true;
+  assert(opts != 0);
+  assert(out != 0);
+  fprintf(out, "%lu%s\n", cnt, cnt == opts->limit ? "+" : "");
 }
 
 /**
- * starts the xxx (bad word on github) in n-threads
+ * prints a horizontal rule of the fancy output
  *
- * @see find_solution_st
- *
- * @param  grid the sudoku grid
- * @param  idx  the index in the grid to be checked
- * @return      true if a thread came back with a solution, false otherwise
+ * @param out output-file
+ * @param lft left border
+ * @param fil filler above/below a slot
+ * @param thn crossing inside a group
+ * @param thk crossing between groups
+ * @param rgt right border
  */
-static bool find_solution_mt (
-  unsigned grid[]
+static void print_rule (
+  FILE *out,
+  const char *lft,
+  const char *fil,
+  const char *thn,
+  const char *thk,
+  const char *rgt
 ) {
-  assert(grid != 0);
-  /* keep things simple, stupid */
-  /* one thread for each possible number */
-  pthread_t pool[9] = {0};
-  unsigned *smem[9] = {0};
-  unsigned pidx = 0;
-
-  /* to keep track of running threads */
-  bool pact[9] = {false};
-  /* status flag */
-  bool sfnd = false;
-
-  /* find the first empty slot 
-    with least possibilities */
-  unsigned idx;
-  sud_mask can = 0;
-
-  idx = find_slot(grid, &can);
-
-  if (idx == NOINDEX) {
-    /* no empty slot found */
-    return true;
-  }
-
-  if (can == NOCANDS) {
-    /* no candidates */
-    return false;
-  }
-
-  /* start one thread for each possible number */
-  for (unsigned num = 1; num <= 9; ++num) {
-    if (can & (1 << num)) {
-      unsigned *tmem = calloc(9*9+1, sizeof(unsigned));
-      pthread_t *thrd = &pool[pidx];
-      solve_fork(thrd, grid, tmem, idx, num);
-      /* next thread */
-      pact[pidx] = true;
-      smem[pidx] = tmem;
-      pidx += 1;
-    }
-  }
-
-  /* how many threads are in use */
-  unsigned puse = pidx;
-
-  /* wait for all threads to come back */
-  while (puse > 0) {
-    /* join threads and check if one came 
-      back with a solution */
-    for (unsigned pi = 0; pi < pidx; ++pi) {
-      if (pact[pi] == false) {
-        continue;
-      }
-      /* handle thread */
-      pthread_t *thrd = &pool[pi];
-      unsigned *tmem = smem[pi];
-      if (solve_join(thrd, pi, grid, &sfnd, tmem)) {
-        /* thread came back */
-        puse -= 1;
-        pact[pi] = false;
-        free(tmem);
-      }
+  fputs(lft, out);
+  for (unsigned col = 0; col < SSIZE; ++col) {
+    fputs(fil, out);
+    if (col < SSIZE - 1) {
+      fputs(col % SBOX == SBOX - 1 ? thk : thn, out);
     }
-    /* wait a bit */
-    usleep(1000);
-  }
-
-  /* stop here */
-  return sfnd;
-}
-
-/**
- * sudoku solver entrypoint
- *
- * @param  grid the sudoku grid
- * @param  use_threads whenever to use threaded or not
- * @return      true if a complete solution was found, false otherwise
- */
-static inline bool solve_puzzle (
-  unsigned grid[],
-  bool use_threads
-) {
-  assert(grid != 0);
-  /* start xxx (badword on github) */
-  if (use_threads) {
-    /* multi-threaded */
-    return find_solution_mt(grid);
   }
-  /* single threaded */
-  return find_solution_st(grid);
+  fputs(rgt, out);
+  fputs("\n", out);
 }
 
 /**
@@ -423,7 +234,7 @@ static inline bool solve_puzzle (
  * @param out
  */
 static void print_puzzle_fancy (
-  unsigned grid[],
+  const sud_cell grid[],
   FILE *out
 ) {
   assert(grid != 0);
@@ -431,48 +242,34 @@ static void print_puzzle_fancy (
   #if defined(_WIN32)
     /* windows does not like UTF8 stuff in the console */
     /* UTF8 is (somewhat) supported, but ... linux is superior! */
-    unsigned col = 0;
-    fputs("+---+---+---+---+---+---+---+---+---+\n", out);
-    for (unsigned idx = 0; idx < (9*9); ++idx) {
-      if (!grid[idx]) {
-        /* empty slot (0) */
-        fputs("|   ", out);
-      } else {
-        /* filled slot */
-        fprintf(out, "| %u ", grid[idx]);
-      }
-      if (col++ == 8) {
-        /* next row */
-        fputs("|\n+---+---+---+---+---+---+---+---+---+\n", out);
-        col = 0;
+    print_rule(out, "+", "---", "+", "+", "+");
+    for (unsigned row = 0; row < SSIZE; ++row) {
+      for (unsigned col = 0; col < SSIZE; ++col) {
+        fprintf(out, "| %c ", sud_symbol(grid[row * SSIZE + col]));
       }
+      fputs("|\n", out);
+      print_rule(out, "+", "---", "+", "+", "+");
     }
   #else
     /* use fancy UTF8 "blocks" */
-    unsigned row = 0;
-    unsigned col = 0;
-    fputs("┏━━━┯━━━┯━━━┳━━━┯━━━┯━━━┳━━━┯━━━┯━━━┓\n", out);
-    for (unsigned idx = 0; idx < (9*9); ++idx) {
-      if (!grid[idx]) {
-        fprintf(out, "%s   ", col % 3 ? "│" : "┃");
+    print_rule(out, "┏", "━━━", "┯", "┳", "┓");
+    for (unsigned row = 0; row < SSIZE; ++row) {
+      for (unsigned col = 0; col < SSIZE; ++col) {
+        fprintf(out, "%s %c ", col % SBOX ? "│" : "┃",
+          sud_symbol(grid[row * SSIZE + col]));
+      }
+      fputs("┃\n", out);
+      if (row == SSIZE - 1) {
+        /* last row */
+        break;
+      }
+      if ((row + 1) % SBOX) {
+        print_rule(out, "┠", "───", "┼", "╂", "┨");
       } else {
-        fprintf(out, "%s %u ", col % 3 ? "│" : "┃", grid[idx]);
-      }
-      if (col++ > 7) {
-        fputs("┃", out);
-        if (row++ < 8) {
-          if (row % 3) {
-            fputs("\n┠───┼───┼───╂───┼───┼───╂───┼───┼───┨\n", out);
-          } else {
-            fputs("\n┣━━━┿━━━┿━━━╋━━━┿━━━┿━━━╋━━━┿━━━┿━━━┫\n", out);
-          }
-        } else {
-          fputs("\n", out);
-        }
-        col = 0;
+        print_rule(out, "┣", "━━━", "┿", "╋", "┫");
       }
     }
-    fputs("┗━━━┷━━━┷━━━┻━━━┷━━━┷━━━┻━━━┷━━━┷━━━┛\n", out);
+    print_rule(out, "┗", "━━━", "┷", "┻", "┛");
   #endif
 }
 
@@ -485,7 +282,7 @@ static void print_puzzle_fancy (
  * @param out  output-file
  */
 static void print_puzzle (
-  unsigned grid[], 
+  const sud_cell grid[],
   FILE *out,
   bool fancy
 ) {
@@ -494,14 +291,15 @@ static void print_puzzle (
 
   if (!fancy) {
     /* simple output format used by @German */
-    unsigned col = 0;
-    for (unsigned idx = 0; idx < (9*9); ++idx) {
-      fprintf(out, "%u", grid[idx]);
-      if (col++ > 7) {
-        fputs("\n", out);
-        col = 0;
+    char buf[SSIZE * (SSIZE + 1)];
+    unsigned pos = 0;
+    for (unsigned idx = 0; idx < SCELLS; ++idx) {
+      buf[pos++] = sud_symbol(grid[idx]);
+      if (idx % SSIZE == SSIZE - 1) {
+        buf[pos++] = '\n';
       }
     }
+    fwrite(buf, 1, pos, out);
   } else {
     print_puzzle_fancy(grid, out);
   }
@@ -509,78 +307,56 @@ static void print_puzzle (
   fputs("\n", out);
 }
 
+/**
+ * prints the grid as a single line, used in batch mode
+ *
+ * @param grid the sudoku grid
+ * @param out  output-file
+ */
+static void print_puzzle_line (
+  const sud_cell grid[],
+  FILE *out
+) {
+  assert(grid != 0);
+  assert(out != 0);
+  char buf[SCELLS + 1];
+  for (unsigned idx = 0; idx < SCELLS; ++idx) {
+    buf[idx] = sud_symbol(grid[idx]);
+  }
+  buf[SCELLS] = '\n';
+  fwrite(buf, 1, sizeof(buf), out);
+}
+
+
 /**
  * reads the input grid
  *
+ * @param ctx  the solver
  * @param grid
  * @param inp
  */
 static void read_puzzle_input (
-  unsigned grid[],
+  struct sud_ctx *ctx,
+  sud_cell grid[],
   FILE *inp
 ) {
+  assert(ctx != 0);
   assert(grid != 0);
   assert(inp != 0);
-  /* for error reporting */
-  unsigned rows[9][9] = {{0}};
-  unsigned cols[9][9] = {{0}};
-  bool grps[9][9] = {{false}};
+  char buf[SCELLS];
   unsigned col = 0;
   unsigned row = 0;
 
-  for (unsigned idx = 0; idx < (9 * 9); ++idx) {
-    char chr = fgetc(inp);
+  for (unsigned idx = 0; idx < SCELLS; ++idx) {
+    int chr = fgetc(inp);
     if (chr == EOF) {
       whops(
         "premature end of input in row %u and column %u",
         row + 1, col + 1
       );
     }
-    if (chr != ' ') {
-      if (chr < '1' || chr > '9') {
-        /* out of bounds */
-        whops(
-          "invalid value `%c` (%i) in row %u and column %u",
-          chr, chr, row + 1, col + 1
-        );
-      }
-      /* get unsigned number from character */
-      unsigned val = chr - '0';
-      unsigned off = val - 1;
-      /* check if value is unique in current row */
-      if (rows[row][off]) {
-        whops(
-          "duplicate value %u in row %u (column %u)"
-          " - value already seen in column %u",
-          val, row + 1, col + 1,
-          rows[row][off] + 1
-        );
-      }
-      /* check if value is unique in current column */
-      if (cols[col][off]) {
-        whops(
-          "duplicate value %u in column %u (row %u)"
-          " - value already seen in row %u",
-          val, col + 1, row + 1,
-          cols[col][off] + 1
-        );
-      }
-      /* check if value is unique in current 3*3 group */
-      unsigned grp = row / 3 * 3 + col / 3;
-      if (grps[grp][off]) {
-        whops(
-          "duplicate value %u in group %u "
-          "(row %u and column %u)",
-          val, grp + 1, row + 1, col + 1
-        );
-      }
-      /* store given information */
-      grid[idx] = val;
-      rows[row][off] = col;
-      cols[col][off] = row;
-      grps[grp][off] = true;
-    }
-    if (col++ == 8) {
+    buf[idx] = chr;
+    if (col++ == SSIZE - 1) {
       /* line is complete */
       chr = fgetc(inp);
       if (chr != '\n') {
@@ -593,116 +369,2440 @@ static void read_puzzle_input (
       row += 1;
     }
   }
+
+  size_t used;
+  if (sud_parse(ctx, grid, buf, SCELLS, &used) != SUD_OK) {
+    whops("%s", sud_message(ctx));
+  }
 }
 
 /**
- * parses program options
+ * reads the next grid in batch mode. a grid is either
+ * given as SSIZE lines with SSIZE characters each or as a
+ * single line with SCELLS characters. empty lines between
+ * grids are skipped
  *
- * @param opts option bucket
- * @param argc program argument count
- * @param argv program argument values
+ * @param  ctx  the solver
+ * @param  grid
+ * @param  inp
+ * @return      false if the end of input was reached
  */
-static void parse_sopts (
-  struct sopts *opts,
-  int argc,
-  char *argv[]
+static bool read_puzzle_batch (
+  struct sud_ctx *ctx,
+  sud_cell grid[],
+  FILE *inp
 ) {
-  assert(opts != 0);
-  opts->threads = true;
-  opts->fancy = false;
-  opts->help = false;
-  opts->test = false;
-
-  if (argc == 1) {
-    /* no options passed */
-    return;
-  }
+  assert(ctx != 0);
+  assert(grid != 0);
+  assert(inp != 0);
+  /* SSIZE lines with "\r\n" + NUL, enough for one line with SCELLS */
+  char buf[SSIZE * (SSIZE + 2) + 1];
+  size_t len = 0;
+  size_t used;
 
-  for (unsigned i = 1; i < argc; ++i) {
-    if (strcmp(argv[i], "-s") == 0) {
-      opts->threads = false;
-      continue;
-    }
-    if (strcmp(argv[i], "-f") == 0) {
-      opts->fancy = true;
-      continue;
+  for (;;) {
+    if (!fgets(buf + len, sizeof(buf) - len, inp)) {
+      if (len == 0) {
+        /* end of input */
+        return false;
+      }
+      /* message of the incomplete grid */
+      whops("%s", sud_message(ctx));
     }
-    if (strcmp(argv[i], "-h") == 0 ||
-        strcmp(argv[i], "-?") == 0) {
-      opts->help = true;
-      continue;
+    len += strlen(buf + len);
+    const int res = sud_parse(ctx, grid, buf, len, &used);
+    if (res == SUD_OK) {
+      return true;
     }
-    if (strcmp(argv[i], "-t") == 0) {
-      opts->test = true;
-      continue;
+    if (res != SUD_MORE) {
+      whops("%s", sud_message(ctx));
     }
+    /* drop empty lines, keep the rows read so far */
+    memmove(buf, buf + used, len - used);
+    len -= used;
   }
 }
 
+/* grids in flight of the rating mode, rated ahead of the printed ones */
+#define SRATES 4096
+
 /**
- * prints the usage-help
+ * a thread of the rating mode with its own solver
+ */
+struct srater {
+  struct srates *rates;
+  struct sud_ctx *ctx;
+  pthread_t thrd;
+  /* the cpu of the thread, 0 if not pinned */
+  const unsigned *cpu;
+};
+
+/**
+ * the grids of the rating mode, a window of SRATES grids
+ * in a ring. the threads rate them for the whole batch and
+ * the reader prints them in input order, so one hard grid
+ * only holds back the output, not the other threads
+ */
+struct srates {
+  /* the grids, their ratings and status codes, grid n in slot
+    n % SRATES, `rated` marks the slots that can be printed */
+  sud_cell (*grids)[SCELLS];
+  struct sud_rating *rts;
+  int *res;
+  bool *rated;
+  /* grids read, taken by a thread and printed */
+  unsigned long pushed;
+  unsigned long taken;
+  unsigned long printed;
+  /* protects the counters, `rated` and `quit` */
+  pthread_mutex_t mtx;
+  /* signaled when a grid was pushed or the threads should quit */
+  pthread_cond_t work;
+  /* signaled when a grid was rated */
+  pthread_cond_t ready;
+  bool quit;
+  /* the threads and the configuration of their solvers */
+  struct srater *wrks;
+  unsigned jobs;
+  struct sud_conf conf;
+};
+
+/**
+ * returns the number of worker threads
  *
+ * @param  opts program options
+ * @return      the number, at least 1
  */
-static void print_usage ()
-{
-  puts("usage:");
-  puts("\t./ssud [-s] [-f] [-h] input");
-  puts("\noptions:");
-  puts("\t-s\tenable single-threaded mode");
-  puts("\t-f\tenable fancy output-format (UTF8 blocks on linux)");
-  puts("\t-h\tshows this help");
-  puts("");
+static unsigned worker_jobs (
+  const struct sopts *opts
+) {
+  assert(opts != 0);
+  long jobs = 1;
+  if (opts->threads) {
+    jobs = opts->jobs ? opts->jobs : sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  return jobs > 0 ? jobs : 1;
 }
 
 /**
- * main entry point
+ * prints the rating of a puzzle: the score, the hardest
+ * technique and the search nodes
  *
+ * @param rt  the rating
+ * @param res the status of `sud_rate`
+ * @param out output-file
  */
-int main (int argc, char *argv[])
-{
-  /* handle options */
-  struct sopts opts;
-  parse_sopts(&opts, argc, argv);
+static void print_rating (
+  const struct sud_rating *rt,
+  int res,
+  FILE *out
+) {
+  assert(rt != 0);
+  assert(out != 0);
+  if (res == SUD_OK) {
+    fprintf(out, "%.1f %s %lu\n",
+      rt->score, sud_tech_name(rt->tech), rt->nodes);
+  } else if (res == SUD_NOSOL) {
+    fputs("no solution\n", out);
+  } else {
+    fprintf(out, "gave up after %lu nodes\n", rt->nodes);
+  }
+}
 
-  /* help wanted! */
-  if (opts.help) {
-    print_usage();
-    return 0;
+/**
+ * opens the solver of a rating thread, pinned first, so
+ * the solver is allocated on the cpu
+ *
+ * @param wk the thread
+ */
+static void rate_solver (
+  struct srater *wk
+) {
+  assert(wk != 0);
+  if (wk->cpu) {
+    sud_pin(*wk->cpu);
   }
+  const int res = sud_open(&wk->ctx, &wk->rates->conf);
+  if (res != SUD_OK) {
+    whops("unable to create a solver: %s", sud_strerror(res));
+  }
+}
 
-  /* read grid */
-  unsigned grid[(9 * 9)] = {0};
+/**
+ * callback for pthread, rates grids until the
+ * rating mode is closed
+ *
+ * @param pass the thread
+ */
+static void * rate_worker (
+  void *pass
+) {
+  struct srater *wk = pass;
+  struct srates *rs = wk->rates;
+  rate_solver(wk);
+  pthread_mutex_lock(&rs->mtx);
+  for (;;) {
+    while (!rs->quit && rs->taken == rs->pushed) {
+      pthread_cond_wait(&rs->work, &rs->mtx);
+    }
+    if (rs->taken == rs->pushed) {
+      /* closed */
+      break;
+    }
+    const unsigned slot = rs->taken++ % SRATES;
+    pthread_mutex_unlock(&rs->mtx);
+    /* the slot is not reused before it is printed */
+    rs->res[slot] = sud_rate(wk->ctx, rs->grids[slot], &rs->rts[slot]);
+    pthread_mutex_lock(&rs->mtx);
+    rs->rated[slot] = true;
+    pthread_cond_signal(&rs->ready);
+  }
+  pthread_mutex_unlock(&rs->mtx);
+  return 0;
+}
 
-  static unsigned hard[] = {
-    0,0,0,5,0,1,0,0,0,
-    0,9,0,0,0,0,8,0,0,
-    0,6,0,0,0,0,0,0,0,
-    4,0,1,0,0,0,0,0,0,
-    0,0,0,0,7,0,0,9,0,
-    0,0,0,0,0,0,0,3,0,
-    8,0,0,0,0,0,1,0,5,
-    0,0,0,2,0,0,4,0,0,
-    0,0,0,3,6,0,0,0,0
+/**
+ * creates the threads and buffers of the rating mode
+ *
+ * @param  opts program options
+ * @return      the rating mode
+ */
+static struct srates * rate_open (
+  const struct sopts *opts
+) {
+  assert(opts != 0);
+  struct srates *rs = calloc(1, sizeof(*rs));
+  if (!rs) {
+    whops("unable to allocate memory for the ratings");
+  }
+  rs->jobs = worker_jobs(opts);
+  rs->grids = calloc(SRATES, sizeof(*rs->grids));
+  rs->rts = calloc(SRATES, sizeof(*rs->rts));
+  rs->res = calloc(SRATES, sizeof(*rs->res));
+  rs->rated = calloc(SRATES, sizeof(bool));
+  rs->wrks = calloc(rs->jobs, sizeof(*rs->wrks));
+  if (!rs->grids || !rs->rts || !rs->res || !rs->rated || !rs->wrks) {
+    whops("unable to allocate memory for the ratings");
+  }
+  pthread_mutex_init(&rs->mtx, 0);
+  pthread_cond_init(&rs->work, 0);
+  pthread_cond_init(&rs->ready, 0);
+  /* one single-threaded solver per thread, opened by the thread */
+  const struct sud_conf conf = {
+    .engine = SUD_MASK,
+    .budget = opts->budget,
+    .timeout = opts->timeout,
+    .heur = opts->heur
   };
-  
-  if (opts.test) {
-    /* use hard input */
-    memcpy(grid, hard, sizeof(unsigned)*(9*9));
-  } else {
-    read_puzzle_input(grid, stdin);
+  rs->conf = conf;
+  for (unsigned num = 0; num < rs->jobs; ++num) {
+    rs->wrks[num].rates = rs;
+    rs->wrks[num].cpu = opts->cpus ? &opts->cpus[num] : 0;
   }
-
-  if (opts.fancy) {
-    /* print input grid */
-    print_puzzle(grid, stdout, true);
+  if (rs->jobs == 1) {
+    /* no thread needed, the reader rates the grids */
+    rate_solver(&rs->wrks[0]);
+    return rs;
   }
+  for (unsigned num = 0; num < rs->jobs; ++num) {
+    struct srater *wk = &rs->wrks[num];
+    if (pthread_create(&wk->thrd, 0, rate_worker, wk) != 0) {
+      whops("unable to start rating thread %u", num);
+    }
+  }
+  return rs;
+}
 
-  if (solve_puzzle(grid, opts.threads)) {
-    /* puzzle was solved, print output grid */
-    print_puzzle(grid, stdout, opts.fancy);
-  } else {
-    fputs("no solution\n", stdout);
+/**
+ * prints the rated grids in input order, waits for
+ * the grids before `upto` to be rated
+ *
+ * @param rs   the rating mode
+ * @param upto print at least up to this grid
+ * @param out  output-file
+ */
+static void rate_print (
+  struct srates *rs,
+  unsigned long upto,
+  FILE *out
+) {
+  assert(rs != 0);
+  pthread_mutex_lock(&rs->mtx);
+  while (rs->printed < rs->pushed) {
+    const unsigned slot = rs->printed % SRATES;
+    if (!rs->rated[slot]) {
+      if (rs->printed >= upto) {
+        break;
+      }
+      pthread_cond_wait(&rs->ready, &rs->mtx);
+      continue;
+    }
+    rs->rated[slot] = false;
+    pthread_mutex_unlock(&rs->mtx);
+    const int res = rs->res[slot];
+    if (res != SUD_OK && res != SUD_NOSOL && res != SUD_LIMIT) {
+      whops("grid %lu: %s", rs->printed + 1, sud_strerror(res));
+    }
+    print_rating(&rs->rts[slot], res, out);
+    pthread_mutex_lock(&rs->mtx);
+    rs->printed += 1;
+  }
+  pthread_mutex_unlock(&rs->mtx);
+}
+
+/**
+ * adds a grid to the rating mode and prints the grids that
+ * are done, waits for the oldest one if the window is full
+ *
+ * @param rs   the rating mode
+ * @param grid the sudoku grid
+ * @param out  output-file
+ */
+static void rate_push (
+  struct srates *rs,
+  const sud_cell grid[],
+  FILE *out
+) {
+  assert(rs != 0);
+  if (rs->jobs == 1) {
+    /* rated right away */
+    struct sud_rating rt;
+    const int res = sud_rate(rs->wrks[0].ctx, grid, &rt);
+    if (res != SUD_OK && res != SUD_NOSOL && res != SUD_LIMIT) {
+      whops("grid %lu: %s", rs->printed + 1, sud_strerror(res));
+    }
+    print_rating(&rt, res, out);
+    rs->printed += 1;
+    return;
+  }
+  if (rs->pushed - rs->printed == SRATES) {
+    /* the slot of the oldest grid is needed */
+    rate_print(rs, rs->printed + 1, out);
+  }
+  /* the slot is not used by the threads until it is pushed */
+  memcpy(rs->grids[rs->pushed % SRATES], grid, SCELLS * sizeof(sud_cell));
+  pthread_mutex_lock(&rs->mtx);
+  rs->pushed += 1;
+  pthread_cond_signal(&rs->work);
+  pthread_mutex_unlock(&rs->mtx);
+  rate_print(rs, 0, out);
+}
+
+/**
+ * rates the rest of the grids, stops the threads
+ * and frees the rating mode
+ *
+ * @param rs  the rating mode, may be 0
+ * @param out output-file
+ */
+static void rate_close (
+  struct srates *rs,
+  FILE *out
+) {
+  if (!rs) {
+    return;
+  }
+  if (rs->jobs > 1) {
+    rate_print(rs, rs->pushed, out);
+    pthread_mutex_lock(&rs->mtx);
+    rs->quit = true;
+    pthread_cond_broadcast(&rs->work);
+    pthread_mutex_unlock(&rs->mtx);
+    for (unsigned num = 0; num < rs->jobs; ++num) {
+      pthread_join(rs->wrks[num].thrd, 0);
+    }
+  }
+  for (unsigned num = 0; num < rs->jobs; ++num) {
+    sud_close(rs->wrks[num].ctx);
+  }
+  pthread_cond_destroy(&rs->ready);
+  pthread_cond_destroy(&rs->work);
+  pthread_mutex_destroy(&rs->mtx);
+  free(rs->wrks);
+  free(rs->rated);
+  free(rs->res);
+  free(rs->rts);
+  free(rs->grids);
+  free(rs);
+}
+
+/**
+ * solves a grid of the batch mode and prints its line
+ *
+ * @param ctx   the solver
+ * @param rates the rating mode, 0 if not rating
+ * @param grid  the sudoku grid
+ * @param out   output-file
+ * @param opts  program options
+ */
+static void solve_batch_grid (
+  struct sud_ctx *ctx,
+  struct srates *rates,
+  sud_cell grid[],
+  FILE *out,
+  const struct sopts *opts
+) {
+  if (rates) {
+    /* printed in input order once it is rated */
+    rate_push(rates, grid, out);
+    return;
+  }
+  int res;
+  if (opts->count) {
+    /* one count per line */
+    unsigned long cnt;
+    res = count_solutions(ctx, grid, opts, &cnt);
+    if (res == SUD_OK) {
+      print_count(cnt, opts, out);
+    }
+  } else {
+    res = solve_puzzle(ctx, grid);
+    if (res == SUD_OK) {
+      print_puzzle_line(grid, out);
+    } else if (res == SUD_NOSOL) {
+      fputs("no solution\n", out);
+    }
+  }
+  if (res == SUD_LIMIT) {
+    print_gaveup(ctx, out);
+  }
+}
+
+/**
+ * batch mode on a regular file, the grids are parsed
+ * straight from a mapping of the file without copies
+ *
+ * @param  ctx   the solver
+ * @param  rates the rating mode, 0 if not rating
+ * @param  inp   the input, read from its current offset
+ * @param  out   output-file
+ * @param  opts  program options
+ * @return       false if the input can not be mapped
+ */
+static bool solve_batch_map (
+  struct sud_ctx *ctx,
+  struct srates *rates,
+  FILE *inp,
+  FILE *out,
+  const struct sopts *opts
+) {
+  const int fd = fileno(inp);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    return false;
+  }
+  const off_t off = lseek(fd, 0, SEEK_CUR);
+  if (off < 0 || off >= st.st_size) {
+    /* empty input is fine */
+    return off >= 0;
+  }
+  const size_t len = st.st_size;
+  const char *map = mmap(0, len, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED) {
+    return false;
+  }
+  posix_madvise((void *) map, len, POSIX_MADV_SEQUENTIAL);
+
+  sud_cell grid[SCELLS];
+  size_t pos = off;
+  size_t used;
+  for (;;) {
+    const int res = sud_parse(ctx, grid, map + pos, len - pos, &used);
+    pos += used;
+    if (res == SUD_MORE && pos == len) {
+      /* only empty lines left */
+      break;
+    }
+    if (res != SUD_OK) {
+      whops("%s", sud_message(ctx));
+    }
+    solve_batch_grid(ctx, rates, grid, out, opts);
+  }
+
+  munmap((void *) map, len);
+  return true;
+}
+
+/**
+ * batch mode, solves grids until the end of input and
+ * prints one line per grid in input order
+ *
+ * @param ctx  the solver
+ * @param inp
+ * @param out
+ * @param opts program options
+ */
+static void solve_batch (
+  struct sud_ctx *ctx,
+  FILE *inp,
+  FILE *out,
+  const struct sopts *opts
+) {
+  assert(inp != 0);
+  assert(out != 0);
+  /* large stdio buffers, must be set before any I/O */
+  static char ibuf[1 << 16];
+  static char obuf[1 << 16];
+  setvbuf(out, obuf, _IOFBF, sizeof(obuf));
+
+  /* the rating mode rates the grids on all threads */
+  struct srates *rates = opts->rate ? rate_open(opts) : 0;
+
+  if (!solve_batch_map(ctx, rates, inp, out, opts)) {
+    /* pipes and terminals */
+    setvbuf(inp, ibuf, _IOFBF, sizeof(ibuf));
+    sud_cell grid[SCELLS];
+    while (read_puzzle_batch(ctx, grid, inp)) {
+      solve_batch_grid(ctx, rates, grid, out, opts);
+    }
+  }
+
+  rate_close(rates, out);
+  fflush(out);
+}
+
+/**
+ * state of the streaming mode
+ */
+struct sstream {
+  FILE *out;
+  /* remaining solutions */
+  unsigned long left;
+};
+
+/**
+ * `senum` callback of the streaming mode
+ *
+ * @param  grid the solution
+ * @param  arg  the stream
+ * @return      false if the stream is done
+ */
+static bool stream_solution (
+  const sud_cell grid[],
+  void *arg
+) {
+  struct sstream *ss = arg;
+  /* a full pipe blocks here and pauses the search */
+  print_puzzle_line(grid, ss->out);
+  ss->left -= 1;
+  return ss->left > 0 && !ferror(ss->out);
+}
+
+/**
+ * streams the solutions of a grid as single lines,
+ * the cursor is printed to stderr if the limit is hit
+ *
+ * @param ctx  the solver
+ * @param grid the sudoku grid
+ * @param out  output-file
+ * @param opts program options
+ */
+static void stream_solutions (
+  struct sud_ctx *ctx,
+  const sud_cell grid[],
+  FILE *out,
+  const struct sopts *opts
+) {
+  assert(grid != 0);
+  assert(out != 0);
+  assert(opts != 0);
+  static char obuf[1 << 16];
+  setvbuf(out, obuf, _IOFBF, sizeof(obuf));
+
+  struct sstream ss = { out, opts->max };
+  struct sud_enum en;
+  en.emit = stream_solution;
+  en.arg = &ss;
+  en.len = SUD_NOCURSOR;
+  en.count = 0;
+
+  if (opts->cursor) {
+    /* "@" followed by one symbol per branch */
+    const char *cur = opts->cursor + 1;
+    en.len = strlen(cur);
+    if (en.len > SCELLS) {
+      whops("invalid cursor `%s`", opts->cursor);
+    }
+    for (unsigned dep = 0; dep < en.len; ++dep) {
+      en.path[dep] = sud_value(cur[dep]);
+      if (en.path[dep] == 0) {
+        whops("invalid cursor `%s`", opts->cursor);
+      }
+    }
+  }
+
+  const int res = sud_enum(ctx, grid, &en);
+  if (res != SUD_OK && res != SUD_STOP) {
+    whops("%s", sud_message(ctx));
+  }
+  fflush(out);
+  if (ferror(out)) {
+    whops("unable to write solutions");
+  }
+
+  if (res == SUD_STOP) {
+    /* resume with -r */
+    fputc('@', stderr);
+    for (unsigned dep = 0; dep < en.len; ++dep) {
+      fputc(sud_symbol(en.path[dep]), stderr);
+    }
+    fputc('\n', stderr);
+  }
+}
+
+/**
+ * returns a monotonic timestamp in microseconds
+ *
+ * @return the timestamp
+ */
+static double bench_clock ()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/**
+ * compares two timings, used with qsort
+ *
+ * @param  a
+ * @param  b
+ * @return   <0, 0 or >0
+ */
+static int bench_cmp (
+  const void *a,
+  const void *b
+) {
+  const double x = *(const double *) a;
+  const double y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * timings of a grid in benchmark mode
+ */
+struct sbench {
+  /* min, median and p99 wall time in microseconds */
+  double min;
+  double med;
+  double p99;
+  /* wall time of all runs */
+  double total;
+  /* search nodes of a run */
+  unsigned long nodes;
+};
+
+/**
+ * returns the name of the solver in benchmark results
+ *
+ * @param  opts program options
+ * @return      the name
+ */
+static const char * bench_name (
+  const struct sopts *opts
+) {
+  assert(opts != 0);
+  return opts->engine == SUD_DLX ? "swip-dlx" :
+    opts->engine == SUD_BITS ? "swip-bits" :
+    opts->threads ? "swip-mt" : "swip-st";
+}
+
+/**
+ * loads the grid files of the benchmark mode
+ *
+ * @param  ctx  the solver (parser)
+ * @param  opts program options
+ * @return      one grid per file
+ */
+static sud_cell (*bench_load (
+  struct sud_ctx *ctx,
+  const struct sopts *opts
+))[SCELLS] {
+  assert(opts != 0);
+  if (opts->nfiles == 0) {
+    whops("benchmark mode requires grid files");
+  }
+  sud_cell (*grids)[SCELLS] = calloc(opts->nfiles, sizeof(*grids));
+  if (!grids) {
+    whops("unable to allocate benchmark memory");
+  }
+  for (unsigned i = 0; i < opts->nfiles; ++i) {
+    FILE *inp = fopen(opts->files[i], "r");
+    if (!inp) {
+      whops("unable to open `%s`", opts->files[i]);
+    }
+    read_puzzle_input(ctx, grids[i], inp);
+    fclose(inp);
+  }
+  return grids;
+}
+
+/**
+ * opens the csv output of the benchmark mode
+ *
+ * @param  opts program options
+ * @return      the file or 0 if there is none
+ */
+static FILE * bench_csv (
+  const struct sopts *opts
+) {
+  assert(opts != 0);
+  if (!opts->csv) {
+    return 0;
+  }
+  FILE *csv = fopen(opts->csv, "w");
+  if (!csv) {
+    whops("unable to open `%s`", opts->csv);
+  }
+  fputs("engine,grid,reps,min_us,median_us,p99_us,nodes\n", csv);
+  return csv;
+}
+
+/**
+ * solves a grid `reps` times after `warm` warmup runs
+ *
+ * @param ctx  the solver
+ * @param grid the sudoku grid, not modified
+ * @param file name of the grid file
+ * @param opts program options
+ * @param time `reps` timings (scratch)
+ * @param res  the timings (output)
+ */
+static void bench_grid (
+  struct sud_ctx *ctx,
+  const sud_cell grid[],
+  const char *file,
+  const struct sopts *opts,
+  double *time,
+  struct sbench *res
+) {
+  assert(opts != 0);
+  assert(res != 0);
+  const unsigned reps = opts->reps;
+  res->total = 0;
+  for (unsigned run = 0; run < opts->warm + reps; ++run) {
+    sud_cell sol[SCELLS];
+    memcpy(sol, grid, sizeof(sol));
+    const double beg = bench_clock();
+    const int err = solve_puzzle(ctx, sol);
+    const double end = bench_clock();
+    if (err == SUD_LIMIT) {
+      whops("gave up on `%s` after %lu nodes", file, sud_nodes(ctx));
+    }
+    if (err != SUD_OK) {
+      whops("no solution for `%s`", file);
+    }
+    if (run >= opts->warm) {
+      time[run - opts->warm] = end - beg;
+      res->total += end - beg;
+    }
+    res->nodes = sud_nodes(ctx);
+  }
+  qsort(time, reps, sizeof(double), bench_cmp);
+  res->min = time[0];
+  res->med = time[reps / 2];
+  res->p99 = time[(reps * 99 + 99) / 100 - 1];
+}
+
+/**
+ * benchmark mode, solves every grid file `reps` times after
+ * `warm` warmup runs and reports min/median/p99 wall time and
+ * search nodes per grid, optionally as csv too
+ *
+ * @param ctx  the solver
+ * @param opts program options
+ * @param out  output for the table
+ */
+static void run_bench (
+  struct sud_ctx *ctx,
+  const struct sopts *opts,
+  FILE *out
+) {
+  assert(opts != 0);
+  assert(out != 0);
+  const char *name = bench_name(opts);
+  const unsigned reps = opts->reps;
+  sud_cell (*grids)[SCELLS] = bench_load(ctx, opts);
+  double *time = calloc(reps, sizeof(double));
+  if (!time) {
+    whops("unable to allocate benchmark memory");
+  }
+  FILE *csv = bench_csv(opts);
+
+  fprintf(out, "%s, %s kernels, %u runs per grid (%u warmup)\n\n",
+    name, sud_isa_name(sud_isa_active()), reps, opts->warm);
+  fprintf(out, "%-24s %12s %12s %12s %12s\n",
+    "grid", "min [us]", "median [us]", "p99 [us]", "nodes");
+
+  double total = 0;
+  for (unsigned i = 0; i < opts->nfiles; ++i) {
+    struct sbench bn;
+    bench_grid(ctx, grids[i], opts->files[i], opts, time, &bn);
+    total += bn.total;
+    fprintf(out, "%-24s %12.1f %12.1f %12.1f %12lu\n",
+      opts->files[i], bn.min, bn.med, bn.p99, bn.nodes);
+    if (csv) {
+      fprintf(csv, "%s,%s,%u,%.3f,%.3f,%.3f,%lu\n",
+        name, opts->files[i], reps, bn.min, bn.med, bn.p99, bn.nodes);
+    }
+  }
+
+  const unsigned long solves = (unsigned long) reps * opts->nfiles;
+  fprintf(out, "\n%lu solves in %.3f s, %.1f solves/s\n",
+    solves, total / 1e6, solves / (total / 1e6));
+
+  if (csv) {
+    fclose(csv);
+  }
+  free(time);
+  free(grids);
+}
+
+/* heuristics compared by `run_bench_heurs` */
+#define SHEURS 3
+
+/**
+ * benchmark mode of all heuristics, solves every grid file with
+ * each of them and reports the median wall time and the search
+ * nodes side by side, plus the heuristic with the fewest nodes
+ *
+ * @param ctx  the solver (parser)
+ * @param conf configuration of the solvers, the heuristic is replaced
+ * @param opts program options
+ * @param out  output for the table
+ */
+static void run_bench_heurs (
+  struct sud_ctx *ctx,
+  const struct sud_conf *conf,
+  const struct sopts *opts,
+  FILE *out
+) {
+  assert(conf != 0);
+  assert(opts != 0);
+  assert(out != 0);
+  const enum sud_heur heurs[SHEURS] = {
+    SUD_HEUR_MRV, SUD_HEUR_UNIT, SUD_HEUR_LCV
+  };
+  const char *name = bench_name(opts);
+  const unsigned reps = opts->reps;
+  sud_cell (*grids)[SCELLS] = bench_load(ctx, opts);
+  double *time = calloc(reps, sizeof(double));
+  if (!time) {
+    whops("unable to allocate benchmark memory");
+  }
+  FILE *csv = bench_csv(opts);
+
+  /* one solver per heuristic */
+  struct sud_ctx *ctxs[SHEURS];
+  for (unsigned hi = 0; hi < SHEURS; ++hi) {
+    struct sud_conf hconf = *conf;
+    hconf.heur = heurs[hi];
+    const int res = sud_open(&ctxs[hi], &hconf);
+    if (res != SUD_OK) {
+      whops("unable to create the solver: %s", sud_strerror(res));
+    }
+  }
+
+  fprintf(out, "%s, %s kernels, median of %u runs per grid (%u warmup)\n\n",
+    name, sud_isa_name(sud_isa_active()), reps, opts->warm);
+  fprintf(out, "%-24s", "grid");
+  for (unsigned hi = 0; hi < SHEURS; ++hi) {
+    char col[16];
+    snprintf(col, sizeof(col), "%s [us]", sud_heur_name(heurs[hi]));
+    fprintf(out, " %12s %10s", col, "nodes");
+  }
+  fprintf(out, " %6s\n", "best");
+
+  double total[SHEURS] = {0};
+  unsigned wins[SHEURS] = {0};
+  for (unsigned i = 0; i < opts->nfiles; ++i) {
+    fprintf(out, "%-24s", opts->files[i]);
+    unsigned best = 0;
+    unsigned long low = 0;
+    for (unsigned hi = 0; hi < SHEURS; ++hi) {
+      struct sbench bn;
+      bench_grid(ctxs[hi], grids[i], opts->files[i], opts, time, &bn);
+      total[hi] += bn.total;
+      fprintf(out, " %12.1f %10lu", bn.med, bn.nodes);
+      if (hi == 0 || bn.nodes < low) {
+        /* fewer nodes, ties go to the first heuristic */
+        best = hi;
+        low = bn.nodes;
+      }
+      if (csv) {
+        fprintf(csv, "%s-%s,%s,%u,%.3f,%.3f,%.3f,%lu\n",
+          name, sud_heur_name(heurs[hi]), opts->files[i], reps,
+          bn.min, bn.med, bn.p99, bn.nodes);
+      }
+    }
+    wins[best] += 1;
+    fprintf(out, " %6s\n", sud_heur_name(heurs[best]));
+  }
+
+  fputc('\n', out);
+  for (unsigned hi = 0; hi < SHEURS; ++hi) {
+    fprintf(out, "%-4s fewest nodes on %u of %u grids, %.3f s in total\n",
+      sud_heur_name(heurs[hi]), wins[hi], opts->nfiles, total[hi] / 1e6);
+    sud_close(ctxs[hi]);
+  }
+
+  if (csv) {
+    fclose(csv);
+  }
+  free(time);
+  free(grids);
+}
+
+/**
+ * output of the generator
+ */
+struct sgenout {
+  FILE *out;
+  /* one line per puzzle */
+  bool batch;
+};
+
+/**
+ * `sud_gen` callback, prints a puzzle
+ *
+ * @param  grid the puzzle
+ * @param  arg  the output
+ * @return      false if the output failed
+ */
+static bool gen_print (
+  const sud_cell grid[],
+  void *arg
+) {
+  const struct sgenout *go = arg;
+  if (go->batch) {
+    print_puzzle_line(grid, go->out);
+  } else {
+    print_puzzle(grid, go->out, false);
+  }
+  return !ferror(go->out);
+}
+
+/**
+ * generates puzzles on all cpus (or one thread with -s)
+ *
+ * @param ctx  the solver
+ * @param opts program options
+ * @param out  output-file
+ */
+static void gen_puzzles (
+  struct sud_ctx *ctx,
+  const struct sopts *opts,
+  FILE *out
+) {
+  assert(ctx != 0);
+  assert(opts != 0);
+  assert(out != 0);
+  static char obuf[1 << 16];
+  setvbuf(out, obuf, _IOFBF, sizeof(obuf));
+
+  struct sgenout go = { out, opts->batch };
+  struct sud_gen gen;
+  gen.count = opts->gen;
+  gen.clues = opts->clues;
+  gen.sym = opts->sym;
+  gen.seed = opts->seed;
+  gen.jobs = opts->threads ? opts->jobs : 1;
+  gen.emit = gen_print;
+  gen.arg = &go;
+
+  const int res = sud_generate(ctx, &gen);
+  fflush(out);
+  if (res == SUD_STOP || ferror(out)) {
+    whops("unable to write puzzles");
+  }
+  if (res != SUD_OK) {
+    whops("%s", sud_message(ctx));
+  }
+}
+
+#if defined(__linux__)
+
+/* longest request id with its NUL */
+#define SIDLEN 32
+/* longest request line without the line break */
+#define SREQLEN (SIDLEN + SCELLS)
+/* longest response line, large enough for the error messages */
+#define SRESLEN (SIDLEN + SCELLS + 176)
+/* requests in flight per client before its input is paused */
+#define SPENDING 256
+/* epoll events per wakeup */
+#define SEVENTS 64
+
+/**
+ * a request, queued to the workers and back
+ */
+struct sjob {
+  struct sjob *next;
+  /* the requesting client, only used by the event loop */
+  struct sclient *client;
+  /* request id */
+  char id[SIDLEN];
+  /* the grid as text */
+  char text[SREQLEN];
+  unsigned len;
+  /* the response line */
+  char res[SRESLEN];
+  unsigned rlen;
+};
+
+/**
+ * a client connection, or stdin and stdout
+ */
+struct sclient {
+  struct sclient *prev;
+  struct sclient *next;
+  /* input and output, the same socket except for stdin */
+  int ifd;
+  int ofd;
+  /* unparsed input */
+  char in[2 * (SREQLEN + 2)];
+  size_t ilen;
+  /* unsent output */
+  char *out;
+  size_t opos;
+  size_t olen;
+  size_t osize;
+  /* requests in the workers */
+  unsigned pending;
+  /* no more input */
+  bool eof;
+  /* skipping the rest of a too long line */
+  bool skip;
+  /* no more output, the peer is gone */
+  bool dead;
+  /* closed, freed after the current events */
+  bool closed;
+  /* registered with epoll and the registered events */
+  bool watched;
+  uint32_t events;
+  /* input is a regular file, epoll can not watch it */
+  bool file;
+  /* got responses, see `serve_done` */
+  bool touched;
+  struct sclient *tnext;
+};
+
+/**
+ * the daemon, the queues are shared with the workers
+ */
+struct sdaemon {
+  const struct sopts *opts;
+  pthread_mutex_t mtx;
+  pthread_cond_t work;
+  /* requests in arrival order */
+  struct sjob *todo;
+  struct sjob **tail;
+  /* responses */
+  struct sjob *done;
+  /* stops the workers */
+  bool stop;
+  /* wakes the event loop when responses are done */
+  int efd;
+  int epfd;
+  /* open and closed clients */
+  struct sclient *clients;
+  struct sclient *closed;
+  /* answered requests */
+  unsigned long served;
+};
+
+/**
+ * a worker of the daemon with its own solver
+ */
+struct sserver {
+  struct sdaemon *dm;
+  struct sud_ctx *ctx;
+  pthread_t thrd;
+  /* configuration of the solver and the cpu, 0 if not pinned */
+  const struct sud_conf *conf;
+  const unsigned *cpu;
+};
+
+/* set by SIGINT and SIGTERM */
+static volatile sig_atomic_t squit = 0;
+
+/**
+ * signal handler of the daemon
+ *
+ * @param sig the signal
+ */
+static void serve_signal (
+  int sig
+) {
+  (void) sig;
+  squit = 1;
+}
+
+/**
+ * solves (or counts) the grid of a request and
+ * writes the response line
+ *
+ * @param ctx  the solver of the worker
+ * @param job  the request
+ * @param opts program options
+ */
+static void serve_job (
+  struct sud_ctx *ctx,
+  struct sjob *job,
+  const struct sopts *opts
+) {
+  assert(ctx != 0);
+  assert(job != 0);
+  sud_cell grid[SCELLS];
+  size_t used;
+  int len = -1;
+
+  int res = sud_parse(ctx, grid, job->text, job->len, &used);
+  if (res == SUD_OK && opts->count) {
+    unsigned long cnt;
+    res = sud_count(ctx, grid, opts->limit, &cnt);
+    if (res == SUD_OK) {
+      len = snprintf(job->res, SRESLEN, "%s %lu%s\n",
+        job->id, cnt, cnt == opts->limit ? "+" : "");
+    }
+  } else if (res == SUD_OK) {
+    res = sud_solve(ctx, grid);
+    if (res == SUD_OK) {
+      len = snprintf(job->res, SRESLEN, "%s ", job->id);
+      for (unsigned idx = 0; idx < SCELLS; ++idx) {
+        job->res[len++] = sud_symbol(grid[idx]);
+      }
+      job->res[len++] = '\n';
+    } else if (res == SUD_NOSOL) {
+      len = snprintf(job->res, SRESLEN, "%s no solution\n", job->id);
+    }
+  }
+  if (res == SUD_LIMIT) {
+    len = snprintf(job->res, SRESLEN, "%s gave up after %lu nodes\n",
+      job->id, sud_nodes(ctx));
+  }
+
+  if (len < 0) {
+    len = snprintf(job->res, SRESLEN, "%s error %s\n",
+      job->id, sud_message(ctx));
+    if (len >= SRESLEN) {
+      /* cut the message */
+      len = SRESLEN - 1;
+      job->res[len - 1] = '\n';
+    }
+  }
+  job->rlen = len;
+}
+
+/**
+ * worker thread of the daemon, takes requests until stopped
+ *
+ * @param  arg the worker
+ * @return     0
+ */
+static void * serve_worker (
+  void *arg
+) {
+  struct sserver *sv = arg;
+  struct sdaemon *dm = sv->dm;
+  const uint64_t one = 1;
+
+  /* pinned first, so the solver is on the numa node of the cpu */
+  if (sv->cpu) {
+    sud_pin(*sv->cpu);
+  }
+  const int res = sud_open(&sv->ctx, sv->conf);
+  if (res != SUD_OK) {
+    whops("unable to create a solver: %s", sud_strerror(res));
+  }
+
+  for (;;) {
+    pthread_mutex_lock(&dm->mtx);
+    while (!dm->todo && !dm->stop) {
+      pthread_cond_wait(&dm->work, &dm->mtx);
+    }
+    struct sjob *job = dm->todo;
+    if (!job) {
+      /* stopped */
+      pthread_mutex_unlock(&dm->mtx);
+      return 0;
+    }
+    dm->todo = job->next;
+    if (!dm->todo) {
+      dm->tail = &dm->todo;
+    }
+    pthread_mutex_unlock(&dm->mtx);
+
+    serve_job(sv->ctx, job, dm->opts);
+
+    pthread_mutex_lock(&dm->mtx);
+    job->next = dm->done;
+    dm->done = job;
+    pthread_mutex_unlock(&dm->mtx);
+    /* an eventfd can not overflow this way */
+    if (write(dm->efd, &one, sizeof(one)) < 0) {
+      /* the event loop is already awake */
+    }
+  }
+}
+
+/**
+ * appends output to a client, sent by `serve_flush`
+ *
+ * @param cl  the client
+ * @param buf the output
+ * @param len length of the output
+ */
+static void serve_write (
+  struct sclient *cl,
+  const char *buf,
+  size_t len
+) {
+  assert(cl != 0);
+  if (cl->dead) {
+    return;
+  }
+  if (cl->opos > 0) {
+    /* drop sent output */
+    memmove(cl->out, cl->out + cl->opos, cl->olen - cl->opos);
+    cl->olen -= cl->opos;
+    cl->opos = 0;
+  }
+  if (cl->olen + len > cl->osize) {
+    size_t size = cl->osize ? cl->osize : 4096;
+    while (size < cl->olen + len) {
+      size *= 2;
+    }
+    char *out = realloc(cl->out, size);
+    if (!out) {
+      whops("unable to allocate memory for the output");
+    }
+    cl->out = out;
+    cl->osize = size;
+  }
+  memcpy(cl->out + cl->olen, buf, len);
+  cl->olen += len;
+}
+
+/**
+ * sends pending output of a client
+ *
+ * @param cl the client
+ */
+static void serve_flush (
+  struct sclient *cl
+) {
+  assert(cl != 0);
+  while (!cl->dead && cl->opos < cl->olen) {
+    const ssize_t len = write(cl->ofd, cl->out + cl->opos,
+      cl->olen - cl->opos);
+    if (len < 0 && errno == EINTR) {
+      continue;
+    }
+    if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      return;
+    }
+    if (len <= 0) {
+      /* the peer is gone, drop the output */
+      cl->dead = true;
+      break;
+    }
+    cl->opos += len;
+  }
+  cl->opos = 0;
+  cl->olen = 0;
+}
+
+/**
+ * updates the epoll events of a client and closes
+ * it once it is done
+ *
+ * @param dm the daemon
+ * @param cl the client
+ */
+static void serve_update (
+  struct sdaemon *dm,
+  struct sclient *cl
+) {
+  assert(dm != 0);
+  assert(cl != 0);
+  if (cl->closed) {
+    return;
+  }
+
+  if (cl->pending == 0 && (cl->dead ||
+      (cl->eof && cl->ilen == 0 && cl->olen == 0))) {
+    /* done, freed after the current events */
+    if (cl->watched) {
+      epoll_ctl(dm->epfd, EPOLL_CTL_DEL, cl->ifd, 0);
+    }
+    close(cl->ifd);
+    if (cl->ofd != cl->ifd) {
+      close(cl->ofd);
+    }
+    if (cl->next) {
+      cl->next->prev = cl->prev;
+    }
+    *(cl->prev ? &cl->prev->next : &dm->clients) = cl->next;
+    cl->next = dm->closed;
+    dm->closed = cl;
+    cl->closed = true;
+    return;
+  }
+
+  uint32_t events = 0;
+  if (!cl->eof && !cl->dead && cl->pending < SPENDING &&
+      cl->ilen < sizeof(cl->in)) {
+    events |= EPOLLIN;
+  }
+  if (!cl->dead && cl->olen > 0 && cl->ofd == cl->ifd) {
+    events |= EPOLLOUT;
+  }
+  if (cl->file) {
+    /* read by `serve_files` instead */
+    cl->events = events;
+    return;
+  }
+  /* idle clients are not watched, a hangup is always reported */
+  struct epoll_event ev = { .events = events, .data.ptr = cl };
+  if (events == 0 && cl->watched) {
+    epoll_ctl(dm->epfd, EPOLL_CTL_DEL, cl->ifd, 0);
+    cl->watched = false;
+  } else if (events != 0 && !cl->watched) {
+    epoll_ctl(dm->epfd, EPOLL_CTL_ADD, cl->ifd, &ev);
+    cl->watched = true;
+  } else if (events != cl->events) {
+    epoll_ctl(dm->epfd, EPOLL_CTL_MOD, cl->ifd, &ev);
+  }
+  cl->events = events;
+}
+
+/**
+ * splits the input of a client into requests, a request
+ * is a line with a id, a space and the grid in one line
+ *
+ * @param dm the daemon
+ * @param cl the client
+ */
+static void serve_parse (
+  struct sdaemon *dm,
+  struct sclient *cl
+) {
+  assert(dm != 0);
+  assert(cl != 0);
+  struct sjob *head = 0;
+  struct sjob **tail = &head;
+  size_t pos = 0;
+
+  while (!cl->dead && cl->pending < SPENDING) {
+    char *beg = cl->in + pos;
+    char *end = memchr(beg, '\n', cl->ilen - pos);
+    if (!end) {
+      if (!cl->skip && cl->ilen - pos > SREQLEN + 1) {
+        serve_write(cl, "- error request too long\n", 25);
+        cl->skip = true;
+      }
+      if (cl->skip) {
+        pos = cl->ilen;
+      }
+      break;
+    }
+    pos = end - cl->in + 1;
+    if (cl->skip) {
+      /* end of the too long line */
+      cl->skip = false;
+      continue;
+    }
+    if (end > beg && end[-1] == '\r') {
+      end -= 1;
+    }
+    if (end == beg) {
+      /* empty line */
+      continue;
+    }
+
+    const char *sep = memchr(beg, ' ', end - beg);
+    if (!sep || sep == beg || sep - beg >= SIDLEN ||
+        end - sep - 1 > SREQLEN) {
+      serve_write(cl, "- error malformed request\n", 26);
+      continue;
+    }
+
+    struct sjob *job = malloc(sizeof(*job));
+    if (!job) {
+      whops("unable to allocate memory for a request");
+    }
+    job->client = cl;
+    memcpy(job->id, beg, sep - beg);
+    job->id[sep - beg] = '\0';
+    job->len = end - sep - 1;
+    memcpy(job->text, sep + 1, job->len);
+    job->next = 0;
+    *tail = job;
+    tail = &job->next;
+    cl->pending += 1;
+  }
+
+  memmove(cl->in, cl->in + pos, cl->ilen - pos);
+  cl->ilen -= pos;
+
+  if (head) {
+    pthread_mutex_lock(&dm->mtx);
+    *dm->tail = head;
+    dm->tail = tail;
+    pthread_cond_broadcast(&dm->work);
+    pthread_mutex_unlock(&dm->mtx);
+  }
+}
+
+/**
+ * reads the available input of a client
+ *
+ * @param dm the daemon
+ * @param cl the client
+ */
+static void serve_read (
+  struct sdaemon *dm,
+  struct sclient *cl
+) {
+  assert(dm != 0);
+  assert(cl != 0);
+  while (!cl->eof && cl->ilen < sizeof(cl->in)) {
+    const ssize_t len = read(cl->ifd, cl->in + cl->ilen,
+      sizeof(cl->in) - cl->ilen);
+    if (len < 0 && errno == EINTR) {
+      continue;
+    }
+    if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      break;
+    }
+    if (len <= 0) {
+      cl->eof = true;
+      if (cl->ilen > 0) {
+        /* last line without a line break */
+        cl->in[cl->ilen++] = '\n';
+      }
+      break;
+    }
+    cl->ilen += len;
+    if (cl->pending >= SPENDING) {
+      break;
+    }
+    serve_parse(dm, cl);
+  }
+  serve_parse(dm, cl);
+}
+
+/**
+ * passes finished responses to their clients
+ *
+ * @param dm the daemon
+ */
+static void serve_done (
+  struct sdaemon *dm
+) {
+  assert(dm != 0);
+  uint64_t cnt;
+  if (read(dm->efd, &cnt, sizeof(cnt)) < 0) {
+    /* nothing to read, the responses are taken anyway */
+  }
+
+  pthread_mutex_lock(&dm->mtx);
+  struct sjob *job = dm->done;
+  dm->done = 0;
+  pthread_mutex_unlock(&dm->mtx);
+
+  struct sclient *list = 0;
+  while (job) {
+    struct sjob *next = job->next;
+    struct sclient *cl = job->client;
+    serve_write(cl, job->res, job->rlen);
+    cl->pending -= 1;
+    dm->served += 1;
+    if (!cl->touched) {
+      cl->touched = true;
+      cl->tnext = list;
+      list = cl;
+    }
+    free(job);
+    job = next;
+  }
+
+  while (list) {
+    struct sclient *cl = list;
+    list = cl->tnext;
+    cl->touched = false;
+    if (cl->ilen > 0) {
+      /* continue paused input */
+      serve_parse(dm, cl);
+    }
+    serve_flush(cl);
+    serve_update(dm, cl);
+  }
+}
+
+/**
+ * reads the clients on regular files. epoll refuses them,
+ * but they are always readable, so they are read whenever
+ * they want input
+ *
+ * @param  dm the daemon
+ * @return    true if one of them wants more input right away
+ */
+static bool serve_files (
+  struct sdaemon *dm
+) {
+  assert(dm != 0);
+  bool more = false;
+  for (struct sclient *cl = dm->clients, *next; cl; cl = next) {
+    /* a closed client moves to the closed list */
+    next = cl->next;
+    if (!cl->file || !(cl->events & EPOLLIN)) {
+      continue;
+    }
+    serve_read(dm, cl);
+    serve_flush(cl);
+    serve_update(dm, cl);
+    more |= !cl->closed && (cl->events & EPOLLIN);
+  }
+  return more;
+}
+
+/**
+ * adds a client to the event loop, a regular file
+ * as input is read by `serve_files`
+ *
+ * @param  dm  the daemon
+ * @param  ifd input
+ * @param  ofd output
+ * @return     false if epoll refused the input
+ */
+static bool serve_client (
+  struct sdaemon *dm,
+  int ifd,
+  int ofd
+) {
+  assert(dm != 0);
+  struct sclient *cl = calloc(1, sizeof(*cl));
+  if (!cl) {
+    whops("unable to allocate memory for a client");
+  }
+  fcntl(ifd, F_SETFL, fcntl(ifd, F_GETFL) | O_NONBLOCK);
+  cl->ifd = ifd;
+  cl->ofd = ofd;
+  cl->watched = true;
+  cl->events = EPOLLIN;
+  struct epoll_event ev = { .events = EPOLLIN, .data.ptr = cl };
+  if (epoll_ctl(dm->epfd, EPOLL_CTL_ADD, ifd, &ev) != 0) {
+    if (errno != EPERM) {
+      free(cl);
+      return false;
+    }
+    /* not pollable, a regular file */
+    cl->file = true;
+    cl->watched = false;
+  }
+  cl->next = dm->clients;
+  if (cl->next) {
+    cl->next->prev = cl;
+  }
+  dm->clients = cl;
+  return true;
+}
+
+/**
+ * creates the listening unix socket, a stale
+ * socket file of a previous run is replaced
+ *
+ * @param  path path of the socket
+ * @return      the socket
+ */
+static int serve_listen (
+  const char *path
+) {
+  assert(path != 0);
+  struct sockaddr_un addr = { .sun_family = AF_UNIX };
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    whops("socket path `%s` is too long", path);
+  }
+  strcpy(addr.sun_path, path);
+
+  struct stat st;
+  if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+    unlink(path);
+  }
+
+  const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 ||
+      bind(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0 ||
+      listen(fd, SOMAXCONN) != 0) {
+    whops("unable to listen on `%s`: %s", path, strerror(errno));
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  return fd;
+}
+
+/**
+ * daemon mode, answers requests from a unix socket (or
+ * stdin) on a pool of workers with their own solvers.
+ * requests are lines of "id grid" and may be pipelined,
+ * responses are "id solution", "id no solution",
+ * "id gave up after N nodes" (out of budget) or
+ * "id error message" in the order they are done.
+ * one thread multiplexes all clients with epoll
+ *
+ * @param opts  program options
+ * @param cache result cache of the workers, may be 0
+ */
+static void serve (
+  const struct sopts *opts,
+  struct sud_cache *cache
+) {
+  assert(opts != 0);
+  const bool stdio = strcmp(opts->daemon, "-") == 0;
+  struct sdaemon dm = {0};
+  dm.opts = opts;
+  dm.tail = &dm.todo;
+  pthread_mutex_init(&dm.mtx, 0);
+  pthread_cond_init(&dm.work, 0);
+
+  /* workers block the signals, the event loop takes them */
+  sigset_t mask;
+  sigset_t orig;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGINT);
+  sigaddset(&mask, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &mask, &orig);
+  struct sigaction sa = { .sa_handler = serve_signal };
+  sigaction(SIGINT, &sa, 0);
+  sigaction(SIGTERM, &sa, 0);
+  signal(SIGPIPE, SIG_IGN);
+
+  dm.epfd = epoll_create1(0);
+  dm.efd = eventfd(0, EFD_NONBLOCK);
+  if (dm.epfd < 0 || dm.efd < 0) {
+    whops("unable to create the event loop: %s", strerror(errno));
+  }
+  struct epoll_event ev = { .events = EPOLLIN, .data.ptr = &dm };
+  epoll_ctl(dm.epfd, EPOLL_CTL_ADD, dm.efd, &ev);
+
+  int lfd = -1;
+  if (stdio) {
+    if (!serve_client(&dm, 0, 1)) {
+      whops("unable to read requests from stdin: %s", strerror(errno));
+    }
+  } else {
+    lfd = serve_listen(opts->daemon);
+    ev.data.ptr = 0;
+    epoll_ctl(dm.epfd, EPOLL_CTL_ADD, lfd, &ev);
+  }
+
+  /* one single-threaded solver per worker */
+  const unsigned jobs = worker_jobs(opts);
+  struct sserver *svs = calloc(jobs, sizeof(*svs));
+  if (!svs) {
+    whops("unable to allocate memory for the workers");
+  }
+  struct sud_conf conf = {
+    .engine = opts->engine,
+    .cache = cache,
+    .budget = opts->budget,
+    .timeout = opts->timeout,
+    .heur = opts->heur
+  };
+  for (unsigned num = 0; num < jobs; ++num) {
+    svs[num].dm = &dm;
+    svs[num].conf = &conf;
+    svs[num].cpu = opts->cpus ? &opts->cpus[num] : 0;
+    if (pthread_create(&svs[num].thrd, 0, serve_worker, &svs[num]) != 0) {
+      whops("unable to start worker %u", num);
+    }
+  }
+  if (opts->verbose) {
+    fprintf(stderr, "serving %s with %u workers\n",
+      stdio ? "stdin" : opts->daemon, jobs);
+  }
+
+  struct epoll_event evs[SEVENTS];
+  /* no waiting while a regular file has input left */
+  bool files = true;
+  while (!squit && (!stdio || dm.clients)) {
+    const int cnt = epoll_pwait(dm.epfd, evs, SEVENTS, files ? 0 : -1, &orig);
+    if (cnt < 0 && errno == EINTR) {
+      continue;
+    }
+    if (cnt < 0) {
+      whops("event loop failed: %s", strerror(errno));
+    }
+
+    for (int num = 0; num < cnt; ++num) {
+      if (evs[num].data.ptr == &dm) {
+        serve_done(&dm);
+        continue;
+      }
+      if (evs[num].data.ptr == 0) {
+        /* new connections */
+        int fd;
+        while ((fd = accept(lfd, 0, 0)) >= 0) {
+          if (!serve_client(&dm, fd, fd)) {
+            close(fd);
+          }
+        }
+        continue;
+      }
+      struct sclient *cl = evs[num].data.ptr;
+      if (cl->closed) {
+        continue;
+      }
+      if (evs[num].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+        /* a hangup or error shows up as the end of input */
+        serve_read(&dm, cl);
+      }
+      serve_flush(cl);
+      serve_update(&dm, cl);
+    }
+    files = serve_files(&dm);
+
+    while (dm.closed) {
+      struct sclient *cl = dm.closed;
+      dm.closed = cl->next;
+      free(cl->out);
+      free(cl);
+    }
+  }
+
+  /* stop the workers, unanswered requests are dropped */
+  pthread_mutex_lock(&dm.mtx);
+  dm.stop = true;
+  pthread_cond_broadcast(&dm.work);
+  pthread_mutex_unlock(&dm.mtx);
+  for (unsigned num = 0; num < jobs; ++num) {
+    pthread_join(svs[num].thrd, 0);
+    sud_close(svs[num].ctx);
+  }
+  free(svs);
+
+  for (struct sjob *job = dm.todo, *next; job; job = next) {
+    next = job->next;
+    free(job);
+  }
+  for (struct sjob *job = dm.done, *next; job; job = next) {
+    next = job->next;
+    free(job);
+  }
+  for (struct sclient *cl = dm.clients, *next; cl; cl = next) {
+    next = cl->next;
+    close(cl->ifd);
+    free(cl->out);
+    free(cl);
+  }
+  close(dm.efd);
+  close(dm.epfd);
+  pthread_mutex_destroy(&dm.mtx);
+  pthread_cond_destroy(&dm.work);
+
+  if (lfd >= 0) {
+    close(lfd);
+    unlink(opts->daemon);
+  }
+  if (opts->verbose) {
+    fprintf(stderr, "served %lu requests\n", dm.served);
+  }
+}
+
+#endif
+
+/**
+ * parses a placement: compact, scatter or a list of cpus
+ * and cpu ranges like "0,2,4-7"
+ *
+ * @param place the placement (output)
+ * @param arg   the argument
+ */
+static void parse_place (
+  struct sud_place *place,
+  const char *arg
+) {
+  assert(place != 0);
+  assert(arg != 0);
+  if (strcmp(arg, "compact") == 0) {
+    place->bind = SUD_BIND_COMPACT;
+    return;
+  }
+  if (strcmp(arg, "scatter") == 0) {
+    place->bind = SUD_BIND_SCATTER;
+    return;
+  }
+  unsigned *cpus = 0;
+  unsigned len = 0;
+  const char *pos = arg;
+  for (;;) {
+    char *end;
+    const unsigned long beg = strtoul(pos, &end, 10);
+    unsigned long last = beg;
+    if (end == pos) {
+      whops("invalid placement `%s`", arg);
+    }
+    if (*end == '-') {
+      pos = end + 1;
+      last = strtoul(pos, &end, 10);
+      if (end == pos || last < beg) {
+        whops("invalid cpu range in `%s`", arg);
+      }
+    }
+    if (last >= CPU_SETSIZE) {
+      /* strtoul saturates, nothing wraps around */
+      whops("invalid cpu %lu in `%s` (at most %u)",
+        last, arg, CPU_SETSIZE - 1);
+    }
+    /* one allocation per range */
+    cpus = realloc(cpus, (len + last - beg + 1) * sizeof(unsigned));
+    if (!cpus) {
+      whops("unable to allocate memory for the cpu list");
+    }
+    for (unsigned long cpu = beg; cpu <= last; ++cpu) {
+      cpus[len++] = cpu;
+    }
+    if (*end == 0) {
+      break;
+    }
+    if (*end != ',') {
+      whops("invalid placement `%s`", arg);
+    }
+    pos = end + 1;
+  }
+  place->bind = SUD_BIND_LIST;
+  place->cpus = cpus;
+  place->ncpus = len;
+}
+
+/**
+ * returns the cpus of the solving threads and reports them,
+ * a single thread is the calling one and pinned right away
+ *
+ * @param  opts program options
+ * @param  out  output for the report
+ * @return      cpu per thread
+ */
+static unsigned * place_threads (
+  const struct sopts *opts,
+  FILE *out
+) {
+  assert(opts != 0);
+  assert(out != 0);
+  const unsigned jobs = worker_jobs(opts);
+  unsigned *cpus = calloc(jobs, sizeof(unsigned));
+  unsigned *nodes = calloc(jobs, sizeof(unsigned));
+  if (!cpus || !nodes) {
+    whops("unable to allocate memory for the placement");
+  }
+  const int res = sud_place_cpus(&opts->place, jobs, cpus, nodes);
+  if (res != SUD_OK) {
+    whops("unable to place the threads: %s", res == SUD_EINVAL
+      ? "a cpu is not available or the system is not supported"
+      : sud_strerror(res));
+  }
+  fprintf(out, "%s placement of %u thread%s (thread:cpu/node):",
+    opts->place.bind == SUD_BIND_COMPACT ? "compact" :
+    opts->place.bind == SUD_BIND_SCATTER ? "scatter" : "list",
+    jobs, jobs == 1 ? "" : "s");
+  for (unsigned num = 0; num < jobs; ++num) {
+    fprintf(out, " %u:%u/%u", num, cpus[num], nodes[num]);
+  }
+  fputc('\n', out);
+  free(nodes);
+  if (jobs == 1 && sud_pin(cpus[0]) != SUD_OK) {
+    whops("unable to pin the thread to cpu %u", cpus[0]);
+  }
+  return cpus;
+}
+
+/**
+ * parses program options
+ *
+ * @param opts option bucket
+ * @param argc program argument count
+ * @param argv program argument values
+ */
+static void parse_sopts (
+  struct sopts *opts,
+  int argc,
+  char *argv[]
+) {
+  assert(opts != 0);
+  opts->threads = true;
+  opts->jobs = 0;
+  opts->engine = SUD_MASK;
+  opts->heur = SUD_HEUR_MRV;
+  opts->heurs = false;
+  opts->isa = SUD_ISA_AUTO;
+  opts->fancy = false;
+  opts->place.bind = SUD_BIND_NONE;
+  opts->place.cpus = 0;
+  opts->place.ncpus = 0;
+  opts->cpus = 0;
+  opts->help = false;
+  opts->batch = false;
+  opts->verbose = false;
+  opts->count = false;
+  opts->limit = 0;
+  opts->stream = false;
+  opts->max = 0;
+  opts->cursor = 0;
+  opts->gen = 0;
+  opts->clues = 0;
+  opts->sym = SUD_SYM_NONE;
+  opts->seed = time(0);
+  opts->bench = false;
+  opts->reps = 0;
+  opts->warm = 1;
+  opts->csv = 0;
+  opts->files = 0;
+  opts->nfiles = 0;
+  opts->test = false;
+  opts->daemon = 0;
+  opts->cache = 0;
+  opts->budget = 0;
+  opts->timeout = 0;
+  opts->rate = false;
+
+  if (argc == 1) {
+    /* no options passed */
+    return;
+  }
+
+  for (unsigned i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-s") == 0) {
+      opts->threads = false;
+      continue;
+    }
+    if (strcmp(argv[i], "-x") == 0) {
+      opts->engine = SUD_DLX;
+      continue;
+    }
+    if (strcmp(argv[i], "-E") == 0) {
+      if (i + 1 >= argc) {
+        whops("option -E requires an engine");
+      }
+      i += 1;
+      if (strcmp(argv[i], "mask") == 0) {
+        opts->engine = SUD_MASK;
+      } else if (strcmp(argv[i], "dlx") == 0) {
+        opts->engine = SUD_DLX;
+      } else if (strcmp(argv[i], "bits") == 0 && SBOX == 3) {
+        opts->engine = SUD_BITS;
+      } else {
+        whops("unknown engine `%s`", argv[i]);
+      }
+      continue;
+    }
+    if (strcmp(argv[i], "-H") == 0) {
+      if (i + 1 >= argc) {
+        whops("option -H requires a heuristic");
+      }
+      i += 1;
+      if (strcmp(argv[i], "mrv") == 0) {
+        opts->heur = SUD_HEUR_MRV;
+      } else if (strcmp(argv[i], "unit") == 0) {
+        opts->heur = SUD_HEUR_UNIT;
+      } else if (strcmp(argv[i], "lcv") == 0) {
+        opts->heur = SUD_HEUR_LCV;
+      } else if (strcmp(argv[i], "all") == 0) {
+        opts->heurs = true;
+      } else {
+        whops("unknown heuristic `%s`", argv[i]);
+      }
+      continue;
+    }
+    if (strcmp(argv[i], "-I") == 0) {
+      if (i + 1 >= argc) {
+        whops("option -I requires an instruction set");
+      }
+      i += 1;
+      if (strcmp(argv[i], "auto") == 0) {
+        opts->isa = SUD_ISA_AUTO;
+      } else if (strcmp(argv[i], "generic") == 0) {
+        opts->isa = SUD_ISA_GENERIC;
+      } else if (strcmp(argv[i], "sse4") == 0) {
+        opts->isa = SUD_ISA_SSE4;
+      } else if (strcmp(argv[i], "avx2") == 0) {
+        opts->isa = SUD_ISA_AVX2;
+      } else {
+        whops("unknown instruction set `%s`", argv[i]);
+      }
+      continue;
+    }
+    if (strcmp(argv[i], "-A") == 0) {
+      if (i + 1 >= argc) {
+        whops("option -A requires a placement");
+      }
+      parse_place(&opts->place, argv[++i]);
+      continue;
+    }
+    if (strcmp(argv[i], "-j") == 0) {
+      if (i + 1 >= argc || atoi(argv[i + 1]) <= 0) {
+        whops("option -j requires a positive number");
+      }
+      opts->jobs = atoi(argv[++i]);
+      continue;
+    }
+    if (strcmp(argv[i], "-f") == 0) {
+      opts->fancy = true;
+      continue;
+    }
+    if (strcmp(argv[i], "-b") == 0) {
+      opts->batch = true;
+      continue;
+    }
+    if (strcmp(argv[i], "-v") == 0) {
+      opts->verbose = true;
+      continue;
+    }
+    if (strcmp(argv[i], "-c") == 0) {
+      opts->count = true;
+      opts->limit = 2;
+      const char *arg = i + 1 < argc ? argv[i + 1] : "";
+      if (*arg && strspn(arg, "0123456789") == strlen(arg)) {
+        /* optional limit, 0 counts all solutions */
+        opts->limit = strtoul(argv[++i], 0, 10);
+      }
+      if (opts->limit == 0) {
+        opts->limit = ULONG_MAX;
+      }
+      continue;
+    }
+    if (strcmp(argv[i], "-e") == 0) {
+      opts->stream = true;
+      opts->max = 0;
+      const char *arg = i + 1 < argc ? argv[i + 1] : "";
+      if (*arg && strspn(arg, "0123456789") == strlen(arg)) {
+        /* optional limit, 0 streams all solutions */
+        opts->max = strtoul(argv[++i], 0, 10);
+      }
+      if (opts->max == 0) {
+        opts->max = ULONG_MAX;
+      }
+      continue;
+    }
+    if (strcmp(argv[i], "-r") == 0) {
+      if (i + 1 >= argc || argv[i + 1][0] != '@') {
+        whops("option -r requires a cursor (@...)");
+      }
+      opts->cursor = argv[++i];
+      continue;
+    }
+    if (strcmp(argv[i], "-g") == 0) {
+      if (i + 1 >= argc || atoi(argv[i + 1]) <= 0) {
+        whops("option -g requires a positive number");
+      }
+      opts->gen = strtoul(argv[++i], 0, 10);
+      continue;
+    }
+    if (strcmp(argv[i], "-n") == 0) {
+      if (i + 1 >= argc || atoi(argv[i + 1]) < 0 ||
+          atoi(argv[i + 1]) > SCELLS) {
+        whops("option -n requires a number up to %u", SCELLS);
+      }
+      opts->clues = atoi(argv[++i]);
+      continue;
+    }
+    if (strcmp(argv[i], "-y") == 0) {
+      static const char *syms[] = {
+        "none", "rot2", "rot4", "mirror", "diag"
+      };
+      const unsigned nsyms = sizeof(syms) / sizeof(syms[0]);
+      unsigned sym = nsyms;
+      if (i + 1 < argc) {
+        for (sym = 0; sym < nsyms; ++sym) {
+          if (strcmp(argv[i + 1], syms[sym]) == 0) {
+            break;
+          }
+        }
+      }
+      if (sym == nsyms) {
+        whops("option -y requires none, rot2, rot4, mirror or diag");
+      }
+      opts->sym = sym;
+      i += 1;
+      continue;
+    }
+    if (strcmp(argv[i], "-S") == 0) {
+      if (i + 1 >= argc) {
+        whops("option -S requires a number");
+      }
+      opts->seed = strtoull(argv[++i], 0, 10);
+      continue;
+    }
+    if (strcmp(argv[i], "-B") == 0) {
+      if (i + 1 >= argc || atoi(argv[i + 1]) <= 0) {
+        whops("option -B requires a positive number");
+      }
+      opts->bench = true;
+      opts->reps = atoi(argv[++i]);
+      continue;
+    }
+    if (strcmp(argv[i], "-w") == 0) {
+      if (i + 1 >= argc || atoi(argv[i + 1]) < 0) {
+        whops("option -w requires a number");
+      }
+      opts->warm = atoi(argv[++i]);
+      continue;
+    }
+    if (strcmp(argv[i], "-o") == 0) {
+      if (i + 1 >= argc) {
+        whops("option -o requires a file name");
+      }
+      opts->csv = argv[++i];
+      continue;
+    }
+    if (strcmp(argv[i], "-C") == 0) {
+      if (i + 1 >= argc || atol(argv[i + 1]) <= 0) {
+        whops("option -C requires a positive number");
+      }
+      opts->cache = strtoul(argv[++i], 0, 10);
+      continue;
+    }
+    if (strcmp(argv[i], "-N") == 0) {
+      if (i + 1 >= argc || atol(argv[i + 1]) <= 0) {
+        whops("option -N requires a positive number");
+      }
+      opts->budget = strtoul(argv[++i], 0, 10);
+      continue;
+    }
+    if (strcmp(argv[i], "-T") == 0) {
+      if (i + 1 >= argc || atol(argv[i + 1]) <= 0) {
+        whops("option -T requires a positive number");
+      }
+      opts->timeout = strtoul(argv[++i], 0, 10);
+      continue;
+    }
+    if (strcmp(argv[i], "-R") == 0) {
+      opts->rate = true;
+      continue;
+    }
+    if (strcmp(argv[i], "-D") == 0) {
+      if (i + 1 >= argc) {
+        whops("option -D requires a socket path or -");
+      }
+      opts->daemon = argv[++i];
+      continue;
+    }
+    if (argv[i][0] != '-') {
+      /* grid file, collected in place */
+      if (!opts->files) {
+        opts->files = &argv[i];
+      }
+      argv[opts->files - argv + opts->nfiles] = argv[i];
+      opts->nfiles += 1;
+      continue;
+    }
+    if (strcmp(argv[i], "-h") == 0 ||
+        strcmp(argv[i], "-?") == 0) {
+      opts->help = true;
+      continue;
+    }
+    if (strcmp(argv[i], "-t") == 0) {
+      opts->test = true;
+      continue;
+    }
+  }
+
+  if (opts->count && opts->engine != SUD_MASK) {
+    whops("option -c requires the bitmask engine");
+  }
+  if ((opts->heur != SUD_HEUR_MRV || opts->heurs) &&
+      opts->engine != SUD_MASK) {
+    whops("option -H requires the bitmask engine");
+  }
+  if (opts->heurs && !opts->bench) {
+    whops("option -H all requires the benchmark mode (-B)");
+  }
+  if (opts->stream && opts->engine != SUD_MASK) {
+    whops("option -e requires the bitmask engine");
+  }
+  if (opts->cursor && !opts->stream) {
+    whops("option -r requires -e");
+  }
+  if (opts->rate && (opts->count || opts->stream || opts->gen ||
+      opts->bench || opts->daemon)) {
+    whops("option -R can not be combined with -c, -e, -g, -B or -D");
+  }
+  if (opts->daemon && (opts->stream || opts->gen || opts->bench)) {
+    whops("option -D can not be combined with -e, -g or -B");
+  }
+}
+
+/**
+ * prints the usage-help
+ *
+ */
+static void print_usage ()
+{
+  puts("usage:");
+  puts("\t./ssud [-s] [-x] [-j N] [-f] [-b] [-c [N]] [-N N] [-T us]"
+    " [-v] [-h] input");
+  puts("\t./ssud -e [N] [-r cursor] input");
+  puts("\t./ssud -R [-s] [-j N] [-b] [-N N] [-T us] input");
+  puts("\t./ssud -g N [-n N] [-y sym] [-S seed] [-s] [-j N] [-b]");
+  puts("\t./ssud [-s] [-j N] [-H all] [-I isa] -B N [-w N] [-o csv] grid...");
+  puts("\t./ssud [-s] [-j N] [-c [N]] [-N N] [-T us] [-v] -D socket");
+  puts("\t(threads of all modes can be pinned with -A placement)");
+  puts("\noptions:");
+  puts("\t-s\tenable single-threaded mode");
+  puts("\t-x\tuse the dancing links engine (single-threaded)");
+  puts("\t-E eng\tengine: mask (default), dlx or bits (9*9 only),");
+  puts("\t  \tdlx and bits are single-threaded");
+  puts("\t-H heur\tbranching heuristic: mrv (default, fewest candidates),");
+  puts("\t  \tunit (mrv, ties by the fullest unit) or lcv (mrv, least");
+  puts("\t  \tconstraining number first), all compares them with -B");
+  puts("\t-I isa\tkernels: auto (default, the best of the cpu), generic,");
+  puts("\t  \tsse4 or avx2, e.g. to compare them with -B");
+  puts("\t-j N\tuse N worker threads (default: one per cpu)");
+  puts("\t-A pl\tpin the threads: compact (a numa node at a time),");
+  puts("\t  \tscatter (the nodes take turns) or a cpu list like 0,2,4-7");
+  puts("\t-f\tenable fancy output-format (UTF8 blocks on linux)");
+  puts("\t-b\tbatch mode, solves grids until end of input");
+  printf("\t  \t(%u lines or one line with %u characters per grid,\n",
+    SSIZE, SCELLS);
+  puts(SSIZE == 16
+    ? "\t  \tblanks are spaces or \".\", files are mapped)"
+    : "\t  \tblanks are spaces, \".\" or \"0\", files are mapped)");
+  puts("\t-c [N]\tcount solutions up to N (default: 2, 0 for all),");
+  puts("\t  \tprints the count with a \"+\" if N was reached");
+  puts("\t-e [N]\tstream up to N solutions (default: all), one per line,");
+  puts("\t  \tprints a cursor to stderr if stopped at N");
+  puts("\t-r cur\tresume streaming after the cursor of a previous run");
+  puts("\t-g N\tgenerate N puzzles with a unique solution");
+  puts("\t-n N\ttarget clue count (default: as few as possible)");
+  puts("\t-y sym\tsymmetry: none, rot2, rot4, mirror or diag");
+  puts("\t-S seed\tseed of the generator (default: time)");
+  puts("\t-C N\tcache up to N results, also of puzzles that are the same");
+  puts("\t  \tafter swapping rows, columns or numbers (hit rates with -v)");
+  puts("\t-N N\tgive up a puzzle after about N search nodes");
+  puts("\t-T us\tgive up a puzzle after us microseconds, prints");
+  puts("\t  \t\"gave up after N nodes\" instead of a solution");
+  puts("\t-R\trate the difficulty: score, hardest technique and search");
+  puts("\t  \tnodes, batch mode rates on all cpus (-s or -j N to limit)");
+  puts("\t-v\tprint search statistics to stderr");
+  puts("\t-B N\tbenchmark mode, solves each grid file N times");
+  puts("\t-w N\tbenchmark warmup runs per grid (default: 1)");
+  puts("\t-o csv\twrite benchmark results to a csv file");
+  puts("\t-D sock\tdaemon mode, answers \"id grid\" lines on a unix socket");
+  puts("\t  \t(- for stdin) with \"id solution\" lines in any order");
+  puts("\t-h\tshows this help");
+  puts("");
+}
+
+/**
+ * prints the counters of the result cache
+ *
+ * @param cache the cache
+ * @param out   output-file
+ */
+static void print_cache (
+  struct sud_cache *cache,
+  FILE *out
+) {
+  assert(cache != 0);
+  assert(out != 0);
+  struct sud_cache_info info;
+  sud_cache_info(cache, &info);
+  const unsigned long looks = info.hits + info.misses;
+  fprintf(out,
+    "cache: %lu hits, %lu misses (%.1f%% hit rate), %lu bypassed, "
+    "%lu of %lu entries, %lu evicted\n",
+    info.hits, info.misses, looks ? 100.0 * info.hits / looks : 0.0,
+    info.bypass, info.entries, info.size, info.evicted
+  );
+}
+
+/**
+ * prints the statistics (with -v) and frees the solver
+ *
+ * @param ctx   the solver
+ * @param cache the cache of the solver, may be 0
+ * @param opts  program options
+ * @param wall  wall time in microseconds
+ */
+static void close_solver (
+  struct sud_ctx *ctx,
+  struct sud_cache *cache,
+  const struct sopts *opts,
+  double wall
+) {
+  if (opts->verbose) {
+    sud_stats(ctx, stderr, wall);
+    if (cache) {
+      print_cache(cache, stderr);
+    }
+  }
+  sud_close(ctx);
+  sud_cache_close(cache);
+}
+
+/**
+ * main entry point
+ *
+ */
+int main (int argc, char *argv[])
+{
+  /* handle options */
+  struct sopts opts;
+  parse_sopts(&opts, argc, argv);
+
+  /* help wanted! */
+  if (opts.help) {
+    print_usage();
+    return 0;
+  }
+
+  /* before the first solver */
+  if (sud_isa_select(opts.isa) != SUD_OK) {
+    whops("the cpu does not support `%s`", sud_isa_name(opts.isa));
+  }
+  if (opts.verbose) {
+    fprintf(stderr, "%s kernels\n", sud_isa_name(sud_isa_active()));
+  }
+
+  /* placement of the solving threads, before any of them starts */
+  if (opts.place.bind != SUD_BIND_NONE) {
+    opts.cpus = place_threads(&opts, stderr);
+  }
+
+  /* shared by all solvers */
+  struct sud_cache *cache = 0;
+  if (opts.cache) {
+    const int res = sud_cache_open(&cache, opts.cache);
+    if (res != SUD_OK) {
+      whops("unable to create the cache: %s", sud_strerror(res));
+    }
+  }
+
+  if (opts.daemon) {
+    /* until SIGINT, SIGTERM or the end of stdin */
+    #if defined(__linux__)
+      serve(&opts, cache);
+    #else
+      whops("daemon mode is only available on linux");
+    #endif
+    if (opts.verbose && cache) {
+      print_cache(cache, stderr);
+    }
+    sud_cache_close(cache);
+    return 0;
+  }
+
+  /* workers are reused for every grid, the generator has its own */
+  struct sud_conf conf;
+  conf.engine = opts.engine;
+  conf.threads = opts.threads && !opts.gen && !opts.rate;
+  conf.jobs = opts.jobs;
+  conf.cache = cache;
+  conf.budget = opts.budget;
+  conf.timeout = opts.timeout;
+  conf.heur = opts.heur;
+  conf.place = opts.place;
+  struct sud_ctx *ctx;
+  const int res = sud_open(&ctx, &conf);
+  if (res != SUD_OK) {
+    whops("unable to create the solver: %s", sud_strerror(res));
+  }
+
+  /* for the statistics */
+  const double beg = bench_clock();
+
+  if (opts.bench && opts.heurs) {
+    /* timings per grid file and heuristic */
+    run_bench_heurs(ctx, &conf, &opts, stdout);
+    close_solver(ctx, cache, &opts, bench_clock() - beg);
+    return 0;
+  }
+
+  if (opts.bench) {
+    /* timings per grid file */
+    run_bench(ctx, &opts, stdout);
+    close_solver(ctx, cache, &opts, bench_clock() - beg);
+    return 0;
+  }
+
+  if (opts.gen) {
+    /* no input */
+    gen_puzzles(ctx, &opts, stdout);
+    close_solver(ctx, cache, &opts, bench_clock() - beg);
+    return 0;
+  }
+
+  if (opts.batch) {
+    /* one line per grid */
+    solve_batch(ctx, stdin, stdout, &opts);
+    close_solver(ctx, cache, &opts, bench_clock() - beg);
+    return 0;
+  }
+
+  /* read grid */
+  sud_cell grid[SCELLS] = {0};
+
+  #if SBOX == 3
+  static sud_cell hard[] = {
+    0,0,0,5,0,1,0,0,0,
+    0,9,0,0,0,0,8,0,0,
+    0,6,0,0,0,0,0,0,0,
+    4,0,1,0,0,0,0,0,0,
+    0,0,0,0,7,0,0,9,0,
+    0,0,0,0,0,0,0,3,0,
+    8,0,0,0,0,0,1,0,5,
+    0,0,0,2,0,0,4,0,0,
+    0,0,0,3,6,0,0,0,0
+  };
+  #endif
+  
+  if (opts.test) {
+    /* use hard input */
+    #if SBOX == 3
+      memcpy(grid, hard, sizeof(hard));
+    #else
+      whops("test mode is only available for 9*9 grids");
+    #endif
+  } else {
+    read_puzzle_input(ctx, grid, stdin);
+  }
+
+  if (opts.fancy) {
+    /* print input grid */
+    print_puzzle(grid, stdout, true);
+  }
+
+  if (opts.stream) {
+    /* all solutions */
+    stream_solutions(ctx, grid, stdout, &opts);
+  } else if (opts.rate) {
+    /* difficulty only */
+    struct sud_rating rt;
+    const int res = sud_rate(ctx, grid, &rt);
+    if (res != SUD_OK && res != SUD_NOSOL && res != SUD_LIMIT) {
+      whops("%s", sud_message(ctx));
+    }
+    print_rating(&rt, res, stdout);
+  } else if (opts.count) {
+    /* number of solutions only */
+    unsigned long cnt;
+    if (count_solutions(ctx, grid, &opts, &cnt) == SUD_OK) {
+      print_count(cnt, &opts, stdout);
+    } else {
+      print_gaveup(ctx, stdout);
+    }
+  } else {
+    const int res = solve_puzzle(ctx, grid);
+    if (res == SUD_OK) {
+      /* puzzle was solved, print output grid */
+      print_puzzle(grid, stdout, opts.fancy);
+    } else if (res == SUD_NOSOL) {
+      fputs("no solution\n", stdout);
+    } else {
+      print_gaveup(ctx, stdout);
+    }
   }
 
+  close_solver(ctx, cache, &opts, bench_clock() - beg);
   return 0;
 }